@@ -0,0 +1,557 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+#include "Urho3D-OverLib/AttributeEditorPanel.hpp"
+#include "Urho3D-OverLib/OverLib.hpp"
+#include "Urho3D-OverLib/StateManager.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <Urho3D/Container/HashSet.h>
+#include <Urho3D/Core/Attribute.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/UI/UIElement.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+namespace
+{
+
+/// Give up waiting on background loads after this long
+const long long LOAD_TIMEOUT_USEC = 30000000;
+
+/// Used when the data directory has no UI/DefaultStyle.xml, the styles the
+/// attribute editors ask for without any textures or fonts to load
+const char* BENCHMARK_STYLE =
+    "<?xml version=\"1.0\"?>\n"
+    "<elements>\n"
+    "    <element type=\"Text\">\n"
+    "        <attribute name=\"Color\" value=\"0.85 0.85 0.85 1\" />\n"
+    "    </element>\n"
+    "    <element type=\"CheckBox\">\n"
+    "        <attribute name=\"Min Size\" value=\"16 16\" />\n"
+    "        <attribute name=\"Max Size\" value=\"16 16\" />\n"
+    "        <attribute name=\"Image Rect\" value=\"80 32 96 48\" />\n"
+    "        <attribute name=\"Border\" value=\"4 4 4 4\" />\n"
+    "        <attribute name=\"Hover Image Offset\" value=\"0 16\" />\n"
+    "        <attribute name=\"Checked Image Offset\" value=\"16 0\" />\n"
+    "    </element>\n"
+    "    <element type=\"Button\">\n"
+    "        <attribute name=\"Image Rect\" value=\"16 0 32 16\" />\n"
+    "        <attribute name=\"Border\" value=\"4 4 4 4\" />\n"
+    "        <attribute name=\"Pressed Image Offset\" value=\"16 0\" />\n"
+    "        <attribute name=\"Hover Image Offset\" value=\"0 16\" />\n"
+    "    </element>\n"
+    "    <element type=\"LineEdit\">\n"
+    "        <attribute name=\"Image Rect\" value=\"112 0 128 16\" />\n"
+    "        <attribute name=\"Border\" value=\"4 4 4 4\" />\n"
+    "        <attribute name=\"Clip Border\" value=\"4 4 4 4\" />\n"
+    "        <attribute name=\"Hover Image Offset\" value=\"0 16\" />\n"
+    "        <element type=\"Text\" internal=\"true\">\n"
+    "            <attribute name=\"Selection Color\" value=\"0.7 0.7 0.7 1\" />\n"
+    "        </element>\n"
+    "    </element>\n"
+    "    <element type=\"DropDownList\">\n"
+    "        <attribute name=\"Image Rect\" value=\"16 0 32 16\" />\n"
+    "        <attribute name=\"Border\" value=\"4 4 4 4\" />\n"
+    "        <attribute name=\"Resize Popup\" value=\"true\" />\n"
+    "    </element>\n"
+    "    <element type=\"EditorAttributeText\" style=\"Text\" auto=\"false\" />\n"
+    "    <element type=\"EditorEnumAttributeText\" style=\"Text\" auto=\"false\" />\n"
+    "    <element type=\"EditorAttributeEdit\" style=\"LineEdit\" auto=\"false\" />\n"
+    "    <element type=\"EditorDragSlider\" style=\"Button\" auto=\"false\" />\n"
+    "</elements>\n";
+
+struct BenchmarkResult
+{
+    String name_;
+    unsigned iterations_;
+    long long usec_;
+};
+
+/// Runs every benchmark against a headless engine, no GPU or window needed
+class Benchmark : public Object
+{
+    OBJECT(Benchmark);
+
+public:
+    /// Construct.
+    Benchmark(Context* context);
+
+public:
+    /// Parse the command line, returns false on bad arguments
+    bool Setup(const Vector<String>& arguments);
+    /// Returns the process exit code
+    int Run();
+
+private:
+    void RunCreateAttributeEditor();
+    void RunAttributeValues();
+    void RunPanelRefresh();
+    void RunStateTransitions();
+    void RunBackgroundLoad();
+    bool GenerateResources();
+    /// The UI style passed to the attribute editors
+    void LoadStyle();
+    void AddResult(const String& name, unsigned iterations, long long usec);
+    String FormatResults() const;
+    void HandleResourceDone(StringHash eventType, VariantMap& eventData);
+
+private:
+    SharedPtr<Engine> engine_;
+    SharedPtr<XMLFile> style_;
+    Vector<BenchmarkResult> results_;
+    Vector<String> resourceNames_;
+    String dataDir_;
+    String outputPath_;
+    unsigned numAttributes_;
+    unsigned numValueIterations_;
+    unsigned numTransitions_;
+    unsigned numResources_;
+    unsigned resourceSize_;
+    unsigned numLoaded_;
+    /// A failed background load sends both events, so each is counted once
+    HashSet<StringHash> loadedNames_;
+    bool csv_;
+    /// A check along the way failed, the results are still written
+    bool failed_;
+    /// Written to so the optimizer cannot drop the measured calls
+    unsigned sink_;
+};
+
+/// An attribute of every type the AttributeEditor handles, with two values to
+/// alternate between so SetValue always changes something
+struct BenchmarkAttribute
+{
+    VariantType type_;
+    const char* name_;
+    Variant a_;
+    Variant b_;
+};
+
+Vector<BenchmarkAttribute> GetBenchmarkAttributes()
+{
+    Vector<BenchmarkAttribute> attributes;
+    BenchmarkAttribute attribute;
+
+#define BENCHMARK_ATTRIBUTE(type, name, a, b) \
+    attribute.type_ = type; attribute.name_ = name; attribute.a_ = a; attribute.b_ = b; attributes.Push(attribute)
+
+    BENCHMARK_ATTRIBUTE(VAR_BOOL, "Bool", true, false);
+    BENCHMARK_ATTRIBUTE(VAR_INT, "Int", 1, -12345);
+    BENCHMARK_ATTRIBUTE(VAR_FLOAT, "Float", 1.5f, -0.125f);
+    BENCHMARK_ATTRIBUTE(VAR_VECTOR2, "Vector2", Vector2(1.0f, 2.0f), Vector2(-3.5f, 4.25f));
+    BENCHMARK_ATTRIBUTE(VAR_VECTOR3, "Vector3", Vector3(1.0f, 2.0f, 3.0f), Vector3(-3.5f, 4.25f, 0.5f));
+    BENCHMARK_ATTRIBUTE(VAR_VECTOR4, "Vector4", Vector4(1.0f, 2.0f, 3.0f, 4.0f), Vector4(-3.5f, 4.25f, 0.5f, 8.0f));
+    BENCHMARK_ATTRIBUTE(VAR_QUATERNION, "Quaternion", Quaternion(45.0f, Vector3::UP), Quaternion(-30.0f, Vector3::FORWARD));
+    BENCHMARK_ATTRIBUTE(VAR_COLOR, "Color", Color(1.0f, 0.5f, 0.25f, 1.0f), Color(0.0f, 0.75f, 1.0f, 0.5f));
+    BENCHMARK_ATTRIBUTE(VAR_INTVECTOR2, "IntVector2", IntVector2(1, 2), IntVector2(-300, 4000));
+    BENCHMARK_ATTRIBUTE(VAR_INTRECT, "IntRect", IntRect(0, 0, 640, 480), IntRect(-10, 20, 30, 40));
+    BENCHMARK_ATTRIBUTE(VAR_STRING, "String", String("Benchmark"), String("Another benchmark value"));
+
+#undef BENCHMARK_ATTRIBUTE
+
+    return attributes;
+}
+
+Benchmark::Benchmark(Context* context)
+    : Object(context)
+    , engine_(new Engine(context))
+    , numAttributes_(1000)
+    , numValueIterations_(10000)
+    , numTransitions_(10000)
+    , numResources_(256)
+    , resourceSize_(64)
+    , numLoaded_(0)
+    , csv_(false)
+    , failed_(false)
+    , sink_(0)
+{
+}
+
+bool Benchmark::Setup(const Vector<String>& arguments)
+{
+    for (unsigned i = 0; i < arguments.Size(); ++i) {
+        String argument = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (argument == "-csv") {
+            csv_ = true;
+        }
+        else if (argument == "-o" && hasValue) {
+            outputPath_ = arguments[++i];
+        }
+        else if (argument == "-data" && hasValue) {
+            dataDir_ = AddTrailingSlash(arguments[++i]);
+        }
+        else if (argument == "-attributes" && hasValue) {
+            numAttributes_ = ToUInt(arguments[++i]);
+        }
+        else if (argument == "-iterations" && hasValue) {
+            numValueIterations_ = ToUInt(arguments[++i]);
+        }
+        else if (argument == "-transitions" && hasValue) {
+            numTransitions_ = ToUInt(arguments[++i]);
+        }
+        else if (argument == "-resources" && hasValue) {
+            numResources_ = ToUInt(arguments[++i]);
+        }
+        else if (argument == "-resourcesize" && hasValue) {
+            resourceSize_ = ToUInt(arguments[++i]);
+        }
+        else {
+            PrintLine("Usage: Urho3D-OverLib-Benchmark [-csv] [-o file] [-data dir] [-attributes n] [-iterations n] "
+                "[-transitions n] [-resources n] [-resourcesize n]", true);
+            return false;
+        }
+    }
+
+    if (dataDir_.Empty()) {
+        dataDir_ = GetSubsystem<FileSystem>()->GetProgramDir() + "OverLibBenchmarkData/";
+    }
+    return true;
+}
+
+int Benchmark::Run()
+{
+    // The synthetic resources have to exist before the engine adds the path
+    if (!GenerateResources()) {
+        return EXIT_FAILURE;
+    }
+
+    VariantMap engineParameters;
+    engineParameters["Headless"] = true;
+    engineParameters["LogLevel"] = LOG_WARNING;
+    engineParameters["ResourcePaths"] = dataDir_;
+    engineParameters["ResourcePackages"] = String::EMPTY;
+    engineParameters["AutoloadPaths"] = String::EMPTY;
+    if (!engine_->Initialize(engineParameters)) {
+        PrintLine("Failed to initialize the headless engine", true);
+        return EXIT_FAILURE;
+    }
+    // Frames are only run to finish background loads, never wait between them
+    engine_->SetMaxFps(0);
+    LoadStyle();
+
+    RunCreateAttributeEditor();
+    RunAttributeValues();
+    RunPanelRefresh();
+    RunStateTransitions();
+    RunBackgroundLoad();
+
+    String output = FormatResults();
+    if (outputPath_.Empty()) {
+        PrintLine(output);
+    }
+    else {
+        File file(context_, outputPath_, FILE_WRITE);
+        if (!file.IsOpen()) {
+            PrintLine("Failed to open " + outputPath_ + " for writing", true);
+            return EXIT_FAILURE;
+        }
+        file.Write(output.CString(), output.Length());
+    }
+    return failed_ ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+void Benchmark::RunCreateAttributeEditor()
+{
+    Vector<BenchmarkAttribute> attributes = GetBenchmarkAttributes();
+    Vector<AttributeInfo> infos;
+    for (unsigned i = 0; i < numAttributes_; ++i) {
+        const BenchmarkAttribute& attribute = attributes[i % attributes.Size()];
+        infos.Push(AttributeInfo(attribute.type_, attribute.name_, 0, attribute.a_, AM_DEFAULT));
+    }
+
+    // Editors are parented like an inspector would, so the cost of adding
+    // them is part of it
+    SharedPtr<UIElement> root(new UIElement(context_));
+    HiresTimer timer;
+    for (unsigned i = 0; i < infos.Size(); ++i) {
+        SharedPtr<UIElement> editor = AttributeEditor::CreateAttributeEditor(context_, style_, infos[i], i, 0);
+        if (editor) {
+            root->AddChild(editor);
+        }
+    }
+    AddResult("AttributeEditor.CreateAttributeEditor", infos.Size(), timer.GetUSec(false));
+    sink_ += root->GetNumChildren();
+}
+
+void Benchmark::RunAttributeValues()
+{
+    Vector<BenchmarkAttribute> attributes = GetBenchmarkAttributes();
+    for (unsigned i = 0; i < attributes.Size(); ++i) {
+        const BenchmarkAttribute& attribute = attributes[i];
+        AttributeInfo info(attribute.type_, attribute.name_, 0, attribute.a_, AM_DEFAULT);
+        SharedPtr<UIElement> editor = AttributeEditor::CreateAttributeEditor(context_, style_, info, 0, 0);
+        if (!editor) {
+            LOGWARNING("No attribute editor for " + String(attribute.name_) + ", skipped");
+            continue;
+        }
+
+        HiresTimer timer;
+        for (unsigned j = 0; j < numValueIterations_; ++j) {
+            AttributeEditor::SetValue(editor, (j & 1) ? attribute.b_ : attribute.a_);
+            Variant value = AttributeEditor::GetValue(attribute.a_, editor);
+            sink_ += value.GetType();
+        }
+        AddResult("AttributeEditor.RoundTrip." + String(attribute.name_), numValueIterations_, timer.GetUSec(false));
+    }
+}
+
+void Benchmark::RunPanelRefresh()
+{
+    // An inspector left open on an element something else keeps toggling
+    SharedPtr<UIElement> target(new UIElement(context_));
+    SharedPtr<UIElement> container(new UIElement(context_));
+    SharedPtr<AttributeEditorPanel> panel(new AttributeEditorPanel(context_));
+    panel->SetTarget(target);
+    panel->Populate(style_, container);
+
+    unsigned visibleIndex = M_MAX_UNSIGNED;
+    const Vector<AttributeInfo>* attrs = target->GetAttributes();
+    for (unsigned i = 0; attrs && i < attrs->Size(); ++i) {
+        if (attrs->At(i).name_ == "Is Visible") {
+            visibleIndex = i;
+        }
+    }
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numValueIterations_; ++i) {
+        target->SetVisible((i & 1) != 0);
+        sink_ += panel->Refresh();
+    }
+    AddResult("AttributeEditorPanel.Refresh", numValueIterations_, timer.GetUSec(false));
+
+    // The checkbox sends Toggled for the panel's own writes too, those must
+    // not leave it dirty or Refresh stops following the target
+    if (visibleIndex == M_MAX_UNSIGNED || !panel->GetBinding()->IsBound(visibleIndex)) {
+        LOGWARNING("No bool attribute editor on UIElement, the Refresh dirty check was skipped");
+    }
+    else if (panel->IsDirty(visibleIndex)) {
+        PrintLine("AttributeEditorPanel::Refresh left an attribute changed by the target dirty", true);
+        failed_ = true;
+    }
+}
+
+void Benchmark::RunStateTransitions()
+{
+    StateManager* stateManager = Urho3D::OverLib::OverLib::GetOrCreateSubSystem<StateManager>(context_);
+    SharedPtr<StateObject> loadingState(new StateObject(context_));
+    SharedPtr<StateObject> states[2] = {
+        SharedPtr<StateObject>(new StateObject(context_)),
+        SharedPtr<StateObject>(new StateObject(context_))
+    };
+    stateManager->SetLoadingState(loadingState);
+
+    HiresTimer timer;
+    for (unsigned i = 0; i < numTransitions_; ++i) {
+        stateManager->SetState(states[i & 1]);
+        stateManager->PostLoadingComplete();
+    }
+    AddResult("StateManager.SetStateWithLoading", numTransitions_, timer.GetUSec(false));
+
+    timer.Reset();
+    for (unsigned i = 0; i < numTransitions_; ++i) {
+        StateObject* state = stateManager->GetState() == states[0] ? states[1] : states[0];
+        stateManager->PreloadState(state);
+        stateManager->PostLoadingComplete(state);
+        stateManager->SetState(state);
+    }
+    AddResult("StateManager.SetStatePreloaded", numTransitions_, timer.GetUSec(false));
+
+    stateManager->SetState(0);
+    stateManager->PostLoadingComplete();
+}
+
+void Benchmark::RunBackgroundLoad()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, HANDLER(Benchmark, HandleResourceDone));
+    SubscribeToEvent(E_LOADFAILED, HANDLER(Benchmark, HandleResourceDone));
+
+    // Cold loads every resource from disk, Cached finds all of them already
+    // in the cache and takes the GetResource path instead
+    for (unsigned pass = 0; pass < 2; ++pass) {
+        if (pass == 0) {
+            cache->ReleaseAllResources(true);
+        }
+        numLoaded_ = 0;
+        loadedNames_.Clear();
+
+        HiresTimer timer;
+        for (unsigned i = 0; i < resourceNames_.Size(); ++i) {
+            Urho3D::OverLib::OverLib::SendBackgroundLoadResource<XMLFile>(context_, resourceNames_[i]);
+        }
+        long long queuedUSec = timer.GetUSec(false);
+        while (numLoaded_ < resourceNames_.Size() && timer.GetUSec(false) < LOAD_TIMEOUT_USEC) {
+            engine_->RunFrame();
+        }
+        long long doneUSec = timer.GetUSec(false);
+
+        if (numLoaded_ < resourceNames_.Size()) {
+            LOGWARNING("Timed out waiting on " + String(resourceNames_.Size() - numLoaded_) + " background loads");
+        }
+        String name = pass == 0 ? "SendBackgroundLoadResource.Cold" : "SendBackgroundLoadResource.Cached";
+        AddResult(name + ".Queue", resourceNames_.Size(), queuedUSec);
+        AddResult(name + ".Loaded", numLoaded_, doneUSec);
+    }
+
+    UnsubscribeFromEvent(E_RESOURCEBACKGROUNDLOADED);
+    UnsubscribeFromEvent(E_LOADFAILED);
+}
+
+bool Benchmark::GenerateResources()
+{
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    String directory = dataDir_ + "Benchmark/";
+    if (!fileSystem->CreateDir(directory)) {
+        PrintLine("Failed to create " + directory, true);
+        return false;
+    }
+
+    // Each entry is around 100 bytes, rewritten every run so the resource
+    // size option always applies
+    String content;
+    content.Reserve(resourceSize_ * 100 + 64);
+    content += "<?xml version=\"1.0\"?>\n<benchmark>\n";
+    for (unsigned i = 0; i < resourceSize_; ++i) {
+        content += "    <entry index=\"" + String(i) + "\" value=\"" + String(i * 0.5f) +
+            "\" name=\"Synthetic benchmark entry " + String(i) + "\" />\n";
+    }
+    content += "</benchmark>\n";
+
+    File styleFile(context_, directory + "Style.xml", FILE_WRITE);
+    if (!styleFile.IsOpen()) {
+        PrintLine("Failed to write " + directory + "Style.xml", true);
+        return false;
+    }
+    styleFile.Write(BENCHMARK_STYLE, strlen(BENCHMARK_STYLE));
+    styleFile.Close();
+
+    resourceNames_.Clear();
+    for (unsigned i = 0; i < numResources_; ++i) {
+        String name = "Benchmark/Resource" + String(i) + ".xml";
+        File file(context_, dataDir_ + name, FILE_WRITE);
+        if (!file.IsOpen()) {
+            PrintLine("Failed to write " + dataDir_ + name, true);
+            return false;
+        }
+        file.Write(content.CString(), content.Length());
+        resourceNames_.Push(name);
+    }
+    return true;
+}
+
+void Benchmark::LoadStyle()
+{
+    // Applying the style is most of what building an editor costs, so the
+    // editors are always styled, by the real default style when there is one
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (cache->Exists("UI/DefaultStyle.xml")) {
+        style_ = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
+    }
+    if (!style_) {
+        style_ = cache->GetResource<XMLFile>("Benchmark/Style.xml");
+    }
+    if (!style_) {
+        LOGWARNING("No UI style could be loaded, the attribute editors are measured unstyled");
+    }
+}
+
+void Benchmark::AddResult(const String& name, unsigned iterations, long long usec)
+{
+    BenchmarkResult result;
+    result.name_ = name;
+    result.iterations_ = iterations;
+    result.usec_ = usec;
+    results_.Push(result);
+}
+
+String Benchmark::FormatResults() const
+{
+    String output;
+    if (csv_) {
+        output += "name,iterations,total_ms,ns_per_op\n";
+    }
+    else {
+        output += "{\n    \"library\": \"Urho3D-OverLib\",\n    \"results\": [\n";
+    }
+
+    for (unsigned i = 0; i < results_.Size(); ++i) {
+        const BenchmarkResult& result = results_[i];
+        double totalMs = result.usec_ / 1000.0;
+        double nsPerOp = result.iterations_ ? result.usec_ * 1000.0 / result.iterations_ : 0.0;
+        char line[256];
+        if (csv_) {
+            sprintf(line, "%s,%u,%.3f,%.1f\n", result.name_.CString(), result.iterations_, totalMs, nsPerOp);
+        }
+        else {
+            sprintf(line, "        { \"name\": \"%s\", \"iterations\": %u, \"totalMs\": %.3f, \"nsPerOp\": %.1f }%s\n",
+                result.name_.CString(), result.iterations_, totalMs, nsPerOp, i + 1 < results_.Size() ? "," : "");
+        }
+        output += line;
+    }
+
+    if (!csv_) {
+        output += "    ]\n}\n";
+    }
+    return output;
+}
+
+void Benchmark::HandleResourceDone(StringHash eventType, VariantMap& eventData)
+{
+    // Both events carry the name under the same parameter
+    using namespace ResourceBackgroundLoaded;
+
+    loadedNames_.Insert(StringHash(eventData[P_RESOURCENAME].GetString()));
+    numLoaded_ = loadedNames_.Size();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Benchmark> benchmark(new Benchmark(context));
+    if (!benchmark->Setup(ParseArguments(argc, argv))) {
+        return EXIT_FAILURE;
+    }
+    return benchmark->Run();
+}
@@ -0,0 +1,296 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeEditJournal.hpp"
+#include "Urho3D-OverLib/AttributeEditorPanel.hpp"
+
+#include <cstring>
+
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Scene/Serializable.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+AttributeEditJournal::AttributeEditJournal(Context* context)
+    : Object(context)
+    , position_(0)
+    , nextGroup_(0)
+    , groupDepth_(0)
+    , group_(0)
+    , coalesce_(false)
+    , applying_(false)
+    , maxMemory_(16 * 1024 * 1024)
+{
+    SubscribeToEvent(E_ATTRIBUTEEDITCOMMITTED, HANDLER(AttributeEditJournal, HandleEditCommitted));
+}
+
+AttributeEditJournal::~AttributeEditJournal()
+{
+}
+
+void AttributeEditJournal::Record(Serializable* target, unsigned int index, const Variant& oldValue, const Variant& newValue)
+{
+    if (applying_ || !target) {
+        return;
+    }
+
+    TruncateRedo();
+    unsigned object = GetObjectId(target);
+
+    if (coalesce_ && position_ > 0) {
+        Entry& last = entries_[position_ - 1];
+        if (last.object_ == object && last.index_ == index) {
+            // The last value in the arena is its new value, overwrite it
+            arena_.Resize(last.newOffset_);
+            arena_.Seek(last.newOffset_);
+            arena_.WriteVariant(newValue);
+            EnforceMemoryLimit();
+            return;
+        }
+    }
+
+    Entry entry;
+    entry.object_ = object;
+    entry.index_ = index;
+    entry.group_ = groupDepth_ ? group_ : nextGroup_++;
+    arena_.Seek(arena_.GetSize());
+    entry.offset_ = arena_.GetSize();
+    arena_.WriteVariant(oldValue);
+    entry.newOffset_ = arena_.GetSize();
+    arena_.WriteVariant(newValue);
+
+    entries_.Push(entry);
+    position_ = entries_.Size();
+    coalesce_ = true;
+    EnforceMemoryLimit();
+}
+
+bool AttributeEditJournal::Undo()
+{
+    if (!position_) {
+        return false;
+    }
+
+    unsigned end = position_;
+    unsigned group = entries_[end - 1].group_;
+    while (position_ > 0 && entries_[position_ - 1].group_ == group) {
+        --position_;
+    }
+
+    ApplyEntries(position_, end, false);
+    coalesce_ = false;
+    return true;
+}
+
+bool AttributeEditJournal::Redo()
+{
+    if (position_ >= entries_.Size()) {
+        return false;
+    }
+
+    unsigned begin = position_;
+    unsigned group = entries_[begin].group_;
+    while (position_ < entries_.Size() && entries_[position_].group_ == group) {
+        ++position_;
+    }
+
+    ApplyEntries(begin, position_, true);
+    coalesce_ = false;
+    return true;
+}
+
+void AttributeEditJournal::BeginGroup()
+{
+    if (!groupDepth_++) {
+        group_ = nextGroup_++;
+    }
+    coalesce_ = false;
+}
+
+void AttributeEditJournal::EndGroup()
+{
+    if (!groupDepth_) {
+        throw "Tried to end an attribute edit group that was never begun";
+    }
+    --groupDepth_;
+    coalesce_ = false;
+}
+
+void AttributeEditJournal::Clear()
+{
+    arena_.Clear();
+    entries_.Clear();
+    position_ = 0;
+    objects_.Clear();
+    objectIds_.Clear();
+    coalesce_ = false;
+}
+
+void AttributeEditJournal::SetMaxMemory(unsigned bytes)
+{
+    maxMemory_ = bytes;
+    EnforceMemoryLimit();
+}
+
+unsigned AttributeEditJournal::GetMemoryUse() const
+{
+    // Each id is a node of the map plus its bucket
+    unsigned idBytes = sizeof(HashMap<Serializable*, unsigned>::Node) + sizeof(void*);
+    return arena_.GetSize() + entries_.Size() * sizeof(Entry) + objects_.Size() * sizeof(WeakPtr<Serializable>) +
+        objectIds_.Size() * idBytes;
+}
+
+unsigned AttributeEditJournal::GetObjectId(Serializable* target)
+{
+    HashMap<Serializable*, unsigned>::Iterator i = objectIds_.Find(target);
+    // A destroyed object's address may be reused by a new one
+    if (i != objectIds_.End() && objects_[i->second_].Get() == target) {
+        return i->second_;
+    }
+
+    unsigned id = objects_.Size();
+    objects_.Push(WeakPtr<Serializable>(target));
+    objectIds_[target] = id;
+    return id;
+}
+
+void AttributeEditJournal::TruncateRedo()
+{
+    if (position_ < entries_.Size()) {
+        arena_.Resize(entries_[position_].offset_);
+        entries_.Resize(position_);
+    }
+}
+
+void AttributeEditJournal::ApplyEntries(unsigned begin, unsigned end, bool newValues)
+{
+    applying_ = true;
+
+    // Undone newest first, redone oldest first
+    PODVector<Serializable*> touched;
+    for (unsigned n = 0; n < end - begin; ++n) {
+        const Entry& entry = entries_[newValues ? begin + n : end - 1 - n];
+        Serializable* target = objects_[entry.object_];
+        if (!target) continue;
+
+        target->SetAttribute(entry.index_, ReadValue(newValues ? entry.newOffset_ : entry.offset_));
+        if (!touched.Contains(target)) {
+            touched.Push(target);
+        }
+    }
+
+    for (unsigned i = 0; i < touched.Size(); ++i) {
+        touched[i]->ApplyAttributes();
+    }
+
+    applying_ = false;
+}
+
+Variant AttributeEditJournal::ReadValue(unsigned offset) const
+{
+    MemoryBuffer buffer(arena_.GetData() + offset, arena_.GetSize() - offset);
+    return buffer.ReadVariant();
+}
+
+void AttributeEditJournal::EnforceMemoryLimit()
+{
+    if (GetMemoryUse() <= maxMemory_) {
+        return;
+    }
+
+    // Drop whole groups of the oldest done edits down to 3/4 of the limit so
+    // the arena is not shifted on every edit
+    unsigned target = maxMemory_ / 4 * 3;
+    unsigned dropped = 0;
+    unsigned droppedBytes = 0;
+    while (dropped < position_) {
+        unsigned group = entries_[dropped].group_;
+        unsigned end = dropped;
+        while (end < position_ && entries_[end].group_ == group) {
+            ++end;
+        }
+        // An open group is still being recorded
+        if (groupDepth_ && group == group_) break;
+
+        unsigned bytes = (end < entries_.Size() ? entries_[end].offset_ : arena_.GetSize()) - entries_[dropped].offset_;
+        dropped = end;
+        droppedBytes += bytes;
+        if (GetMemoryUse() - droppedBytes - dropped * sizeof(Entry) <= target) break;
+    }
+    if (!dropped) {
+        return;
+    }
+
+    unsigned base = dropped < entries_.Size() ? entries_[dropped].offset_ : arena_.GetSize();
+    unsigned remaining = arena_.GetSize() - base;
+    unsigned char* data = arena_.GetModifiableData();
+    memmove(data, data + base, remaining);
+    arena_.Resize(remaining);
+    arena_.Seek(remaining);
+
+    entries_.Erase(0, dropped);
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        entries_[i].offset_ -= base;
+        entries_[i].newOffset_ -= base;
+    }
+    position_ -= dropped;
+    CompactObjects();
+}
+
+void AttributeEditJournal::CompactObjects()
+{
+    // Renumbered in order of first use, objects no edit is left for are gone
+    PODVector<unsigned> ids(objects_.Size());
+    for (unsigned i = 0; i < ids.Size(); ++i) {
+        ids[i] = M_MAX_UNSIGNED;
+    }
+    Vector<WeakPtr<Serializable> > objects;
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        unsigned& id = ids[entries_[i].object_];
+        if (id == M_MAX_UNSIGNED) {
+            id = objects.Size();
+            objects.Push(objects_[entries_[i].object_]);
+        }
+        entries_[i].object_ = id;
+    }
+    objects_ = objects;
+
+    // Destroyed ones are only kept for their ids, their edits are skipped
+    objectIds_.Clear();
+    for (unsigned i = 0; i < objects_.Size(); ++i) {
+        if (objects_[i]) {
+            objectIds_[objects_[i].Get()] = i;
+        }
+    }
+}
+
+void AttributeEditJournal::HandleEditCommitted(StringHash eventType, VariantMap& eventData)
+{
+    using namespace AttributeEditCommitted;
+
+    Serializable* target = static_cast<Serializable*>(eventData[P_SERIALIZABLE].GetPtr());
+    Record(target, eventData[P_INDEX].GetUInt(), eventData[P_OLDVALUE], eventData[P_NEWVALUE]);
+}
@@ -21,11 +21,20 @@
 //
 
 #include "Urho3D-OverLib/AttributeEditor.hpp"
+#include "Urho3D-OverLib/AttributeEditorTraits.hpp"
+#include "Urho3D-OverLib/ContainerAttributeEdit.hpp"
 
+#include <cstdio>
+#include <cstring>
 #include <functional>
 
 #include <Urho3D/Core/Attribute.h>
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Scene/Serializable.h>
+#include <Urho3D/Core/Variant.h>
+#include <Urho3D/UI/Button.h>
 #include <Urho3D/UI/CheckBox.h>
 #include <Urho3D/UI/DropDownList.h>
 #include <Urho3D/UI/LineEdit.h>
@@ -39,9 +48,7 @@ using namespace Urho3D;
 
 using namespace OverLib::AttributeEditor;
 
-const unsigned int ATTR_HEIGHT = 19;
 const unsigned int ATTRNAME_WIDTH = 320;
-const char* STRIKED_OUT = "——";
 
 SharedPtr<UIElement> OverLib::AttributeEditor::CreateAttributeEditor(Context* context, Urho3D::XMLFile* style, const AttributeInfo& info, unsigned int index, unsigned int subIndex)//, EventHandler* handler)
 {
@@ -49,24 +56,30 @@ SharedPtr<UIElement> OverLib::AttributeEditor::CreateAttributeEditor(Context* co
     case VAR_BOOL:
         return CreateBoolAttributeEditor(context, style, info, index, subIndex);//, handler);
     case VAR_STRING:
-        //case VAR_BUFFER:
+    case VAR_RESOURCEREF:
         return CreateStringAttributeEditor(context, style, info, index, subIndex);//, handler);
-    case VAR_FLOAT:
-    case VAR_VECTOR2:
-    case VAR_VECTOR3:
-    case VAR_VECTOR4:
-    case VAR_QUATERNION:
-    case VAR_COLOR:
-    case VAR_INTVECTOR2:
-    case VAR_INTRECT:
-    case VAR_INT:
-        return CreateNumAttributeEditor(context, style, info, index, subIndex);//, handler);
+    case VAR_BUFFER:
+    case VAR_VARIANTVECTOR:
+    case VAR_VARIANTMAP:
+    case VAR_RESOURCEREFLIST:
+        return CreateContainerAttributeEditor(context, style, info, index, subIndex);
     default:
+        if (GetNumAttributeOps(info.type_))
+            return CreateNumAttributeEditor(context, style, info, index, subIndex);//, handler);
         LOGWARNING("Failed creating an attribute editor for: " + info.name_);
         return SharedPtr<UIElement>();
     }
 }
 
+SharedPtr<UIElement> OverLib::AttributeEditor::CreateAttributeEditor(Context* context, Urho3D::XMLFile* style, const AttributeInfo& info, unsigned int index, unsigned int subIndex, Binding* binding)
+{
+    SharedPtr<UIElement> editor(CreateAttributeEditor(context, style, info, index, subIndex));
+    if (editor && binding) {
+        binding->Register(info, index, editor);
+    }
+    return editor;
+}
+
 SharedPtr<UIElement> OverLib::AttributeEditor::CreateBoolAttributeEditor(Context* context, Urho3D::XMLFile* style, const AttributeInfo& info, unsigned int index, unsigned int subIndex)//, EventHandler* handler)
 {
     SharedPtr<UIElement> parent(CreateAttributeEditorParent(context, style, info.name_, index, subIndex));
@@ -84,18 +97,15 @@ SharedPtr<UIElement> OverLib::AttributeEditor::CreateBoolAttributeEditor(Context
 
 SharedPtr<UIElement> OverLib::AttributeEditor::CreateNumAttributeEditor(Context* context, Urho3D::XMLFile* style, const AttributeInfo& info, unsigned int index, unsigned int subIndex)//, EventHandler* handler)
 {
-    SharedPtr<UIElement> parent(CreateAttributeEditorParent(context, style, info.name_, index, subIndex));
     VariantType type = info.type_;
+    const NumAttributeOps* ops = GetNumAttributeOps(type);
+    if (!ops) {
+        LOGWARNING("Failed creating a numeric attribute editor for: " + info.name_);
+        return SharedPtr<UIElement>();
+    }
+    unsigned int numCoords = ops->numCoords_;
 
-    unsigned int numCoords = type - VAR_FLOAT + 1;
-    if (type == VAR_QUATERNION)
-        numCoords = 3;
-    else if (type == VAR_COLOR || type == VAR_INTRECT)
-        numCoords = 4;
-    else if (type == VAR_INTVECTOR2)
-        numCoords = 2;
-    else if (type == VAR_INT)
-        numCoords = 1;
+    SharedPtr<UIElement> parent(CreateAttributeEditorParent(context, style, info.name_, index, subIndex));
 
     if (type == VAR_INT && info.enumNames_) {
         SharedPtr<DropDownList> list(new DropDownList(context));
@@ -128,10 +138,8 @@ SharedPtr<UIElement> OverLib::AttributeEditor::CreateNumAttributeEditor(Context*
         for (unsigned int i = 0; i < numCoords; ++i) {
             SharedPtr<LineEdit> edit = CreateAttributeLineEdit(context, style, info.name_ + "_" + String(i), index, subIndex);
             edit->SetVar("Coordinate", i);
-
-            // TODO: CreateDragSlider(edit);
-
             cont->AddChild(edit);
+            CreateDragSlider(edit);
             //if(i==0) edit->SubscribeToEvent(edit, E_TEXTFINISHED, handler);
         }
     }
@@ -150,6 +158,22 @@ SharedPtr< UIElement > OverLib::AttributeEditor::CreateStringAttributeEditor(Con
     return parent;
 }
 
+SharedPtr<UIElement> OverLib::AttributeEditor::CreateContainerAttributeEditor(Context* context, Urho3D::XMLFile* style, const AttributeInfo& info, unsigned int index, unsigned int subIndex)
+{
+    SharedPtr<UIElement> parent(CreateAttributeEditorParent(context, style, info.name_, index, subIndex));
+    // Grows with the entries when expanded
+    parent->SetMaxHeight(M_MAX_INT);
+
+    SharedPtr<ContainerAttributeEdit> edit(new ContainerAttributeEdit(context));
+    parent->AddChild(edit);
+    edit->SetName(info.name_);
+    edit->SetVar("Index", index);
+    edit->SetVar("SubIndex", subIndex);
+    edit->Setup(info.type_);
+
+    return parent;
+}
+
 SharedPtr<UIElement> OverLib::AttributeEditor::CreateAttributeEditorParent(Context* context, Urho3D::XMLFile* style, const String& name, unsigned int index, unsigned int subIndex)
 {
     SharedPtr<UIElement> parent(new UIElement(context));
@@ -184,19 +208,119 @@ SharedPtr<LineEdit> OverLib::AttributeEditor::CreateAttributeLineEdit(Context* c
     return edit;
 }
 
-void SetLineEditValueNumType(LineEdit* edit, const Urho3D::Variant& fromValue, int i, const String& name)
+SharedPtr<Button> OverLib::AttributeEditor::CreateDragSlider(LineEdit* edit)
 {
-    switch (fromValue.GetType()) {
-    case VAR_FLOAT:      edit->SetText(String(fromValue.GetFloat()));                break;
-    case VAR_VECTOR2:    edit->SetText(String(fromValue.GetVector2().Data()[i]));    break;
-    case VAR_VECTOR3:    edit->SetText(String(fromValue.GetVector3().Data()[i]));    break;
-    case VAR_VECTOR4:    edit->SetText(String(fromValue.GetVector4().Data()[i]));    break;
-    case VAR_QUATERNION: edit->SetText(String(fromValue.GetQuaternion().Data()[i])); break;
-    case VAR_COLOR:      edit->SetText(String(fromValue.GetColor().Data()[i]));      break;
-    case VAR_INTVECTOR2: edit->SetText(String(fromValue.GetIntVector2().Data()[i])); break;
-    case VAR_INTRECT:    edit->SetText(String(fromValue.GetIntRect().Data()[i]));    break;
-    case VAR_INT:        edit->SetText(String(fromValue.GetInt()));                  break;
-    default: LOGWARNING("Unable to set number type: " + name + String(i));
+    SharedPtr<Button> slider(new Button(edit->GetContext()));
+    edit->AddChild(slider);
+    slider->SetName(DRAG_SLIDER_NAME);
+    slider->SetStyle("EditorDragSlider");
+    slider->SetFixedHeight(ATTR_HEIGHT - 3);
+    slider->SetFixedWidth(slider->GetHeight());
+    slider->SetAlignment(HA_RIGHT, VA_TOP);
+    slider->SetFocusMode(FM_NOTFOCUSABLE);
+
+    return slider;
+}
+
+StringHash OverLib::AttributeEditor::GetAttributeEditorShape(const AttributeInfo& info)
+{
+    if (info.type_ != VAR_INT || !info.enumNames_) {
+        return StringHash((unsigned)info.type_);
+    }
+
+    // Enum lists with the same names make the same DropDownList
+    String names("Enum");
+    for (int i = 0; info.enumNames_[i]; ++i) {
+        names += ";";
+        names += info.enumNames_[i];
+    }
+    return StringHash(names);
+}
+
+bool OverLib::AttributeEditor::RebindAttributeEditor(UIElement* editor, const AttributeInfo& info, unsigned int index, unsigned int subIndex)
+{
+    if (!editor || editor->GetNumChildren() < 1) {
+        return false;
+    }
+
+    editor->SetName("Edit" + String(index) + "_" + String(subIndex));
+    editor->SetVar("Index", index);
+    editor->SetVar("SubIndex", subIndex);
+
+    UIElement* text = editor->GetChild(0);
+    if (text->GetType() == Text::GetTypeStatic()) {
+        static_cast<Text*>(text)->SetText(info.name_);
+    }
+
+    UIElement* value = editor->GetChild(1);
+    if (!value) {
+        return true;
+    }
+    value->SetName(info.name_);
+    value->SetVar("Index", index);
+    value->SetVar("SubIndex", subIndex);
+
+    // The numeric coordinates are found by name, so they follow the container
+    if (value->GetType() == UIElement::GetTypeStatic()) {
+        unsigned numChildren = value->GetNumChildren();
+        for (unsigned i = 0; i < numChildren; ++i) {
+            UIElement* child = value->GetChild(i);
+            child->SetName(info.name_ + "_" + String(i));
+            child->SetVar("Index", index);
+            child->SetVar("SubIndex", subIndex);
+        }
+    }
+    return true;
+}
+
+/// Numeric editing per VariantType, filled in on first use
+static NumAttributeOps* GetNumAttributeOpsTable()
+{
+    static NumAttributeOps table[MAX_VAR_TYPES];
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        for (unsigned i = 0; i < MAX_VAR_TYPES; ++i) {
+            table[i].numCoords_ = 0;
+            table[i].format_ = 0;
+            table[i].parse_ = 0;
+        }
+        table[VAR_INT] = MakeNumAttributeOps<NumAttributeTraits<VAR_INT> >();
+        table[VAR_FLOAT] = MakeNumAttributeOps<NumAttributeTraits<VAR_FLOAT> >();
+        table[VAR_VECTOR2] = MakeNumAttributeOps<NumAttributeTraits<VAR_VECTOR2> >();
+        table[VAR_VECTOR3] = MakeNumAttributeOps<NumAttributeTraits<VAR_VECTOR3> >();
+        table[VAR_VECTOR4] = MakeNumAttributeOps<NumAttributeTraits<VAR_VECTOR4> >();
+        table[VAR_QUATERNION] = MakeNumAttributeOps<NumAttributeTraits<VAR_QUATERNION> >();
+        table[VAR_COLOR] = MakeNumAttributeOps<NumAttributeTraits<VAR_COLOR> >();
+        table[VAR_INTVECTOR2] = MakeNumAttributeOps<NumAttributeTraits<VAR_INTVECTOR2> >();
+        table[VAR_INTRECT] = MakeNumAttributeOps<NumAttributeTraits<VAR_INTRECT> >();
+    }
+    return table;
+}
+
+const NumAttributeOps* OverLib::AttributeEditor::GetNumAttributeOps(VariantType type)
+{
+    if (type >= MAX_VAR_TYPES) {
+        return 0;
+    }
+    const NumAttributeOps* ops = &GetNumAttributeOpsTable()[type];
+    return ops->numCoords_ ? ops : 0;
+}
+
+void OverLib::AttributeEditor::RegisterNumAttributeType(VariantType type, const NumAttributeOps& ops)
+{
+    if (type >= MAX_VAR_TYPES || !ops.numCoords_ || ops.numCoords_ > MAX_NUM_COORDS || !ops.format_ || !ops.parse_) {
+        throw "Tried to register a numeric attribute type with an invalid type or coordinate count";
+    }
+    GetNumAttributeOpsTable()[type] = ops;
+}
+
+/// Only touch the LineEdit when the text actually differs
+static void SetLineEditText(LineEdit* edit, const char* text)
+{
+    if (edit->GetText() != text) {
+        edit->SetText(text);
+        edit->ApplyAttributes();
     }
 }
 
@@ -212,25 +336,45 @@ void OverLib::AttributeEditor::SetValue(UIElement* toElement, const Urho3D::Vari
         break;
     }
 
-    case VAR_FLOAT:
-    case VAR_VECTOR2:
-    case VAR_VECTOR3:
-    case VAR_VECTOR4:
-    case VAR_QUATERNION:
-    case VAR_COLOR:
-    case VAR_INTVECTOR2:
-    case VAR_INTRECT:
-    case VAR_INT: {
+    case VAR_STRING: {
+        if (toElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
+            LineEdit* edit = static_cast<LineEdit*>(toElement);
+            if (edit->GetText() != fromValue.GetString())
+                edit->SetText(fromValue.GetString());
+        } else
+            LOGWARNING("Failed filling in string for: " + toElement->GetName());
+        break;
+    }
+
+    case VAR_RESOURCEREF: {
+        if (toElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
+            LineEdit* edit = static_cast<LineEdit*>(toElement);
+            if (edit->GetText() != fromValue.GetResourceRef().name_)
+                edit->SetText(fromValue.GetResourceRef().name_);
+        } else
+            LOGWARNING("Failed filling in resource for: " + toElement->GetName());
+        break;
+    }
+
+    case VAR_BUFFER:
+    case VAR_VARIANTVECTOR:
+    case VAR_VARIANTMAP:
+    case VAR_RESOURCEREFLIST: {
+        if (toElement->GetType() == ContainerAttributeEdit::GetTypeStatic()) {
+            static_cast<ContainerAttributeEdit*>(toElement)->SetValue(fromValue);
+        } else
+            LOGWARNING("Failed filling in container for: " + toElement->GetName());
+        break;
+    }
+
+    default: {
         VariantType type = fromValue.GetType();
-        unsigned int numCoords = type - VAR_FLOAT + 1;
-        if (type == VAR_QUATERNION)
-            numCoords = 3;
-        else if (type == VAR_COLOR || type == VAR_INTRECT)
-            numCoords = 4;
-        else if (type == VAR_INTVECTOR2)
-            numCoords = 2;
-        else if (type == VAR_INT)
-            numCoords = 1;
+        const NumAttributeOps* ops = GetNumAttributeOps(type);
+        if (!ops) {
+            LOGWARNING("Failed filling in value for: " + toElement->GetName());
+            break;
+        }
+        unsigned int numCoords = ops->numCoords_;
         if (type == VAR_INT && toElement->GetTypeName() == DropDownList::GetTypeNameStatic()) {
             DropDownList* list = static_cast<DropDownList*>(toElement);
             list->SetSelection(fromValue.GetInt());
@@ -238,6 +382,8 @@ void OverLib::AttributeEditor::SetValue(UIElement* toElement, const Urho3D::Vari
             if (toElement->GetTypeName() != UIElement::GetTypeNameStatic()) {
                 LOGWARNING("Failed filling in string for: " + toElement->GetName());
             }
+            char texts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+            ops->format_(fromValue, texts);
             const String& name = toElement->GetName() + "_";
             for (unsigned int i = 0; i < numCoords; ++i) {
                 UIElement* elem = toElement->GetChild(name + String(i), true);
@@ -245,35 +391,11 @@ void OverLib::AttributeEditor::SetValue(UIElement* toElement, const Urho3D::Vari
                     LOGWARNING("Failed filling in number value for: " + name + String(i));
                     break;
                 }
-                LineEdit* edit = static_cast<LineEdit*>(elem);
-                SetLineEditValueNumType(edit, fromValue, i, name);
-                edit->ApplyAttributes();
+                SetLineEditText(static_cast<LineEdit*>(elem), texts[i]);
             }
         }
         break;
     }
-
-    case VAR_STRING: {
-        if (toElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
-            LineEdit* edit = static_cast<LineEdit*>(toElement);
-            edit->SetText(fromValue.GetString());
-        } else
-            LOGWARNING("Failed filling in string for: " + toElement->GetName());
-        break;
-    }
-
-//         case VAR_BUFFER:
-//             if(toElement->GetTypeName() == LineEdit::GetTypeNameStatic())
-//             {
-//                 LineEdit *edit = static_cast<LineEdit*>(toElement);
-//                 edit->SetText(fromValue.GetBuffer());
-//             }
-//             else
-//                 LOGWARNING("Failed filling in buffer for: "+toElement->GetName());
-//             break;
-
-    default:
-        LOGWARNING("Failed filling in value for: " + toElement->GetName());
     }
 }
 
@@ -289,25 +411,43 @@ Variant OverLib::AttributeEditor::GetValue(const Variant& toValueWithDefault, co
         break;
     }
 
-    case VAR_FLOAT:
-    case VAR_VECTOR2:
-    case VAR_VECTOR3:
-    case VAR_VECTOR4:
-    case VAR_QUATERNION:
-    case VAR_COLOR:
-    case VAR_INTVECTOR2:
-    case VAR_INTRECT:
-    case VAR_INT: {
+    case VAR_STRING: {
+        if (fromElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
+            const LineEdit* edit = static_cast<const LineEdit*>(fromElement);
+            return edit->GetText();
+        } else
+            LOGWARNING("Failed acquiring string from: " + fromElement->GetName());
+        break;
+    }
+
+    case VAR_RESOURCEREF: {
+        if (fromElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
+            const LineEdit* edit = static_cast<const LineEdit*>(fromElement);
+            return ResourceRef(toValueWithDefault.GetResourceRef().type_, edit->GetText());
+        } else
+            LOGWARNING("Failed acquiring resource from: " + fromElement->GetName());
+        break;
+    }
+
+    case VAR_BUFFER:
+    case VAR_VARIANTVECTOR:
+    case VAR_VARIANTMAP:
+    case VAR_RESOURCEREFLIST: {
+        if (fromElement->GetType() == ContainerAttributeEdit::GetTypeStatic()) {
+            return static_cast<const ContainerAttributeEdit*>(fromElement)->GetValue(toValueWithDefault);
+        } else
+            LOGWARNING("Failed acquiring container from: " + fromElement->GetName());
+        break;
+    }
+
+    default: {
         VariantType type = toValueWithDefault.GetType();
-        unsigned int numCoords = type - VAR_FLOAT + 1;
-        if (type == VAR_QUATERNION)
-            numCoords = 3;
-        else if (type == VAR_COLOR || type == VAR_INTRECT)
-            numCoords = 4;
-        else if (type == VAR_INTVECTOR2)
-            numCoords = 2;
-        else if (type == VAR_INT)
-            numCoords = 1;
+        const NumAttributeOps* ops = GetNumAttributeOps(type);
+        if (!ops) {
+            LOGWARNING("Unsupported type of '" + String((int)type) + "' of: " + fromElement->GetName());
+            break;
+        }
+        unsigned int numCoords = ops->numCoords_;
         if (type == VAR_INT && fromElement->GetTypeName() == DropDownList::GetTypeNameStatic()) {
             const DropDownList* list = static_cast<const DropDownList*>(fromElement);
             return Variant(list->GetSelection());
@@ -316,33 +456,371 @@ Variant OverLib::AttributeEditor::GetValue(const Variant& toValueWithDefault, co
                 LOGWARNING("Failed filling in string for: " + fromElement->GetName());
             }
             const String& name = fromElement->GetName() + "_";
-            String output("");
+            const char* texts[MAX_NUM_COORDS];
             for (unsigned int i = 0; i < numCoords; ++i) {
                 UIElement* elem = fromElement->GetChild(name + String(i), true);
                 if (!elem || elem->GetTypeName() != LineEdit::GetTypeNameStatic()) {
                     LOGWARNING("Failed filling in number value for: " + name + String(i));
-                    break;
+                    return toValueWithDefault;
                 }
-                LineEdit* edit = static_cast<LineEdit*>(elem);
-                if (output.Length() > 0) output.Append(' ');
-                output.Append(edit->GetText());
+                texts[i] = static_cast<LineEdit*>(elem)->GetText().CString();
             }
-            return Variant(toValueWithDefault.GetType(), output);
+            return ops->parse_(texts, toValueWithDefault);
         }
         break;
     }
+    }
+    return toValueWithDefault;
+}
+
+
+OverLib::AttributeEditor::Binding::Binding()
+{
+}
+
+OverLib::AttributeEditor::Binding::~Binding()
+{
+}
+
+bool OverLib::AttributeEditor::Binding::Register(const AttributeInfo& info, unsigned int index, UIElement* editor)
+{
+    // The parent holds the name Text then the value widget
+    UIElement* value = editor ? editor->GetChild(1) : 0;
+    if (!value) {
+        LOGWARNING("Failed binding the attribute editor for: " + info.name_);
+        return false;
+    }
+
+    Entry entry;
+    entry.index_ = index;
+    entry.type_ = info.type_;
+    entry.editor_ = editor;
+    entry.value_ = value;
+    entry.numCoords_ = 0;
+    entry.ops_ = GetNumAttributeOps(info.type_);
+
+    // Numeric editors hold a LineEdit per coordinate in their container
+    if (entry.ops_ && value->GetType() == UIElement::GetTypeStatic()) {
+        unsigned numChildren = value->GetNumChildren();
+        for (unsigned i = 0; i < numChildren && entry.numCoords_ < entry.ops_->numCoords_; ++i) {
+            UIElement* child = value->GetChild(i);
+            if (child->GetType() == LineEdit::GetTypeStatic()) {
+                entry.coords_[entry.numCoords_++] = static_cast<LineEdit*>(child);
+            }
+        }
+    }
+
+    Unregister(index);
+    if (indexToEntry_.Size() <= index) {
+        unsigned oldSize = indexToEntry_.Size();
+        indexToEntry_.Resize(index + 1);
+        for (unsigned i = oldSize; i < indexToEntry_.Size(); ++i) {
+            indexToEntry_[i] = M_MAX_UNSIGNED;
+        }
+    }
+    indexToEntry_[index] = entries_.Size();
+    entries_.Push(entry);
+    return true;
+}
+
+void OverLib::AttributeEditor::Binding::Unregister(unsigned int index)
+{
+    if (index >= indexToEntry_.Size() || indexToEntry_[index] == M_MAX_UNSIGNED) {
+        return;
+    }
+
+    // Swap the last entry in to the hole to keep entries_ dense
+    unsigned slot = indexToEntry_[index];
+    unsigned last = entries_.Size() - 1;
+    if (slot != last) {
+        entries_[slot] = entries_[last];
+        indexToEntry_[entries_[slot].index_] = slot;
+    }
+    entries_.Pop();
+    indexToEntry_[index] = M_MAX_UNSIGNED;
+}
+
+void OverLib::AttributeEditor::Binding::Clear()
+{
+    entries_.Clear();
+    indexToEntry_.Clear();
+}
+
+void OverLib::AttributeEditor::Binding::LoadAll(Serializable* source)
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        SetEntryValue(entries_[i], source->GetAttribute(entries_[i].index_));
+    }
+}
+
+unsigned OverLib::AttributeEditor::Binding::SaveAll(Serializable* target)
+{
+    unsigned written = 0;
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        const Entry& entry = entries_[i];
+        Variant origValue = target->GetAttribute(entry.index_);
+        // Parsing the shown text back would round untouched numbers
+        if (ShowsValue(entry, origValue)) continue;
+        Variant value = GetEntryValue(entry, origValue);
+        if (value != origValue) {
+            target->SetAttribute(entry.index_, value);
+            ++written;
+        }
+    }
+    return written;
+}
+
+void OverLib::AttributeEditor::Binding::LoadAll(const PODVector<Serializable*>& sources)
+{
+    if (sources.Size() == 1) {
+        LoadAll(sources[0]);
+        return;
+    }
+    if (sources.Empty()) {
+        return;
+    }
+
+    // One attribute across every source at a time, reusing the value array
+    Vector<Variant> values;
+    values.Resize(sources.Size());
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        const Entry& entry = entries_[i];
+        bool same = true;
+        for (unsigned j = 0; j < sources.Size(); ++j) {
+            values[j] = sources[j]->GetAttribute(entry.index_);
+            if (same && j && values[j] != values[0]) {
+                same = false;
+            }
+        }
+
+        if (same)
+            SetEntryValue(entry, values[0]);
+        else
+            SetEntryMixedValue(entry, values);
+    }
+}
+
+unsigned OverLib::AttributeEditor::Binding::SaveAll(const PODVector<Serializable*>& targets)
+{
+    unsigned written = 0;
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        const Entry& entry = entries_[i];
+        for (unsigned j = 0; j < targets.Size(); ++j) {
+            Variant origValue = targets[j]->GetAttribute(entry.index_);
+            // Untouched or mixed and untouched, each target keeps its own
+            if (ShowsValue(entry, origValue)) continue;
+            Variant value = GetEntryValue(entry, origValue);
+            if (value != origValue) {
+                targets[j]->SetAttribute(entry.index_, value);
+                ++written;
+            }
+        }
+    }
+    return written;
+}
+
+bool OverLib::AttributeEditor::Binding::IsBound(unsigned int index) const
+{
+    return GetEntry(index) != 0;
+}
+
+void OverLib::AttributeEditor::Binding::SetValue(unsigned int index, const Variant& fromValue)
+{
+    const Entry* entry = GetEntry(index);
+    if (entry) {
+        SetEntryValue(*entry, fromValue);
+    }
+}
+
+Variant OverLib::AttributeEditor::Binding::GetValue(unsigned int index, const Variant& toValueWithDefault) const
+{
+    const Entry* entry = GetEntry(index);
+    return entry ? GetEntryValue(*entry, toValueWithDefault) : toValueWithDefault;
+}
+
+UIElement* OverLib::AttributeEditor::Binding::GetEditor(unsigned int index) const
+{
+    const Entry* entry = GetEntry(index);
+    return entry ? entry->editor_.Get() : 0;
+}
+
+void OverLib::AttributeEditor::Binding::GetValueWidgets(unsigned int index, PODVector<UIElement*>& dest) const
+{
+    dest.Clear();
+    const Entry* entry = GetEntry(index);
+    if (!entry) {
+        return;
+    }
+    if (entry->numCoords_) {
+        for (unsigned i = 0; i < entry->numCoords_; ++i) {
+            dest.Push(entry->coords_[i]);
+        }
+    } else {
+        dest.Push(entry->value_);
+    }
+}
+
+const OverLib::AttributeEditor::Binding::Entry* OverLib::AttributeEditor::Binding::GetEntry(unsigned int index) const
+{
+    if (index >= indexToEntry_.Size() || indexToEntry_[index] == M_MAX_UNSIGNED) {
+        return 0;
+    }
+    return &entries_[indexToEntry_[index]];
+}
+
+void OverLib::AttributeEditor::Binding::SetEntryValue(const Entry& entry, const Variant& fromValue)
+{
+    if (fromValue.GetType() != entry.type_) {
+        LOGWARNING("Failed filling in value of the wrong type for: " + entry.value_->GetName());
+        return;
+    }
+
+    switch (entry.type_) {
+    case VAR_BOOL:
+        static_cast<CheckBox*>(entry.value_)->SetChecked(fromValue.GetBool());
+        entry.value_->SetVar("Mixed", Variant::EMPTY);
+        break;
 
     case VAR_STRING: {
-        if (fromElement->GetTypeName() == LineEdit::GetTypeNameStatic()) {
-            const LineEdit* edit = static_cast<const LineEdit*>(fromElement);
-            return edit->GetText();
-        } else
-            LOGWARNING("Failed acquiring string from: " + fromElement->GetName());
+        LineEdit* edit = static_cast<LineEdit*>(entry.value_);
+        if (edit->GetText() != fromValue.GetString())
+            edit->SetText(fromValue.GetString());
+        break;
+    }
+
+    case VAR_RESOURCEREF: {
+        LineEdit* edit = static_cast<LineEdit*>(entry.value_);
+        if (edit->GetText() != fromValue.GetResourceRef().name_)
+            edit->SetText(fromValue.GetResourceRef().name_);
         break;
     }
 
     default:
-        LOGWARNING("Unsupported type of '" + String((int)toValueWithDefault.GetType()) + "' of: " + fromElement->GetName());
+        if (entry.numCoords_) {
+            char texts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+            entry.ops_->format_(fromValue, texts);
+            for (unsigned i = 0; i < entry.numCoords_; ++i) {
+                SetLineEditText(entry.coords_[i], texts[i]);
+            }
+        } else if (entry.value_->GetType() == DropDownList::GetTypeStatic()) {
+            static_cast<DropDownList*>(entry.value_)->SetSelection(fromValue.GetInt());
+        } else if (entry.value_->GetType() == ContainerAttributeEdit::GetTypeStatic()) {
+            static_cast<ContainerAttributeEdit*>(entry.value_)->SetValue(fromValue);
+        }
+    }
+}
+
+void OverLib::AttributeEditor::Binding::SetEntryMixedValue(const Entry& entry, const Vector<Variant>& fromValues)
+{
+    const Variant& first = fromValues[0];
+    if (first.GetType() != entry.type_) {
+        LOGWARNING("Failed filling in value of the wrong type for: " + entry.value_->GetName());
+        return;
+    }
+
+    switch (entry.type_) {
+    case VAR_BOOL: {
+        // A CheckBox has no third state, so remember what it was set to, if
+        // it is saved unchanged every target keeps its own
+        CheckBox* check = static_cast<CheckBox*>(entry.value_);
+        check->SetChecked(first.GetBool());
+        check->SetVar("Mixed", first.GetBool());
+        break;
+    }
+
+    case VAR_STRING:
+    case VAR_RESOURCEREF:
+        static_cast<LineEdit*>(entry.value_)->SetText(STRIKED_OUT);
+        break;
+
+    default:
+        if (entry.numCoords_) {
+            // Only the coordinates that differ are striked out
+            char texts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+            char otherTexts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+            entry.ops_->format_(first, texts);
+            for (unsigned i = 1; i < fromValues.Size(); ++i) {
+                if (fromValues[i].GetType() != entry.type_) continue;
+                entry.ops_->format_(fromValues[i], otherTexts);
+                for (unsigned j = 0; j < entry.numCoords_; ++j) {
+                    if (strcmp(texts[j], otherTexts[j]) != 0) {
+                        strcpy(texts[j], STRIKED_OUT);
+                    }
+                }
+            }
+            for (unsigned i = 0; i < entry.numCoords_; ++i) {
+                SetLineEditText(entry.coords_[i], texts[i]);
+            }
+        } else if (entry.value_->GetType() == DropDownList::GetTypeStatic()) {
+            // No selection shows the placeholder
+            static_cast<DropDownList*>(entry.value_)->SetSelection(M_MAX_UNSIGNED);
+        } else if (entry.value_->GetType() == ContainerAttributeEdit::GetTypeStatic()) {
+            static_cast<ContainerAttributeEdit*>(entry.value_)->SetMixed();
+        }
+    }
+}
+
+bool OverLib::AttributeEditor::Binding::ShowsValue(const Entry& entry, const Variant& value)
+{
+    if (!entry.numCoords_ || value.GetType() != entry.type_) {
+        return false;
+    }
+
+    char texts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+    entry.ops_->format_(value, texts);
+    for (unsigned i = 0; i < entry.numCoords_; ++i) {
+        const String& text = entry.coords_[i]->GetText();
+        if (text != STRIKED_OUT && text != texts[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Variant OverLib::AttributeEditor::Binding::GetEntryValue(const Entry& entry, const Variant& toValueWithDefault)
+{
+    if (toValueWithDefault.GetType() != entry.type_) {
+        return toValueWithDefault;
+    }
+
+    switch (entry.type_) {
+    case VAR_BOOL: {
+        const CheckBox* check = static_cast<const CheckBox*>(entry.value_);
+        const Variant& mixed = check->GetVar("Mixed");
+        if (!mixed.IsEmpty() && mixed.GetBool() == check->IsChecked()) {
+            return toValueWithDefault;
+        }
+        return check->IsChecked();
+    }
+
+    case VAR_STRING: {
+        const String& text = static_cast<const LineEdit*>(entry.value_)->GetText();
+        return text == STRIKED_OUT ? toValueWithDefault : Variant(text);
+    }
+
+    case VAR_RESOURCEREF: {
+        const String& text = static_cast<const LineEdit*>(entry.value_)->GetText();
+        return text == STRIKED_OUT ? toValueWithDefault : Variant(ResourceRef(toValueWithDefault.GetResourceRef().type_, text));
+    }
+
+    default:
+        if (entry.numCoords_) {
+            // Striked out coordinates, and those still showing the value's
+            // own text, are left null to keep its exact coordinate
+            char ownTexts[MAX_NUM_COORDS][NUM_TEXT_LENGTH];
+            entry.ops_->format_(toValueWithDefault, ownTexts);
+            const char* texts[MAX_NUM_COORDS] = { "", "", "", "" };
+            for (unsigned i = 0; i < entry.numCoords_; ++i) {
+                const String& text = entry.coords_[i]->GetText();
+                texts[i] = text == STRIKED_OUT || text == ownTexts[i] ? 0 : text.CString();
+            }
+            return entry.ops_->parse_(texts, toValueWithDefault);
+        } else if (entry.value_->GetType() == DropDownList::GetTypeStatic()) {
+            unsigned selection = static_cast<const DropDownList*>(entry.value_)->GetSelection();
+            return selection == M_MAX_UNSIGNED ? toValueWithDefault : Variant((int)selection);
+        } else if (entry.value_->GetType() == ContainerAttributeEdit::GetTypeStatic()) {
+            return static_cast<const ContainerAttributeEdit*>(entry.value_)->GetValue(toValueWithDefault);
+        }
+        return toValueWithDefault;
     }
-    return toValueWithDefault;
 }
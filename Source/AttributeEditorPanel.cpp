@@ -0,0 +1,403 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Urho3D-OverLib/AttributeEditorPanel.hpp"
+
+#include <Urho3D/Core/Attribute.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Scene/Serializable.h>
+#include <Urho3D/UI/LineEdit.h>
+#include <Urho3D/UI/ListView.h>
+#include <Urho3D/UI/UIElement.h>
+#include <Urho3D/UI/UIEvents.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+AttributeEditorPanel::AttributeEditorPanel(Context* context)
+    : Object(context)
+    , binding_(new AttributeEditor::Binding())
+    , autoApply_(false)
+    , showing_(false)
+    , coalescer_(new AttributeWriteCoalescer(context))
+    , dragSensitivity_(0.1f)
+    , dragIndex_(0)
+    , dragBase_(0.0f)
+    , dragDelta_(0)
+{
+}
+
+AttributeEditorPanel::~AttributeEditorPanel()
+{
+}
+
+void AttributeEditorPanel::SetTarget(Serializable* target)
+{
+    target_ = target;
+    Revert();
+}
+
+Serializable* AttributeEditorPanel::GetTarget() const
+{
+    return target_;
+}
+
+void AttributeEditorPanel::Populate(XMLFile* style, UIElement* container, unsigned int subIndex)
+{
+    Serializable* target = target_;
+    if (!target || !container) {
+        return;
+    }
+
+    const Vector<AttributeInfo>* attrs = target->GetAttributes();
+    if (!attrs) {
+        return;
+    }
+
+    container_ = container;
+    if (pool_) {
+        pool_->SetStyle(style);
+    }
+
+    ListView* list = container->GetType() == ListView::GetTypeStatic() ? static_cast<ListView*>(container) : 0;
+    for (unsigned i = 0; i < attrs->Size(); ++i) {
+        const AttributeInfo& attr = attrs->At(i);
+        if (attr.mode_ & AM_NOEDIT) continue;
+
+        SharedPtr<UIElement> editor;
+        if (pool_)
+            editor = pool_->Checkout(attr, i, subIndex);
+        else
+            editor = AttributeEditor::CreateAttributeEditor(context_, style, attr, i, subIndex);
+        if (!editor || !AddEditor(attr, i, editor)) continue;
+
+        if (list)
+            list->AddItem(editor);
+        else
+            container->AddChild(editor);
+    }
+}
+
+bool AttributeEditorPanel::AddEditor(const AttributeInfo& info, unsigned int index, UIElement* editor)
+{
+    if (!binding_->Register(info, index, editor)) {
+        return false;
+    }
+
+    if (shownValues_.Size() <= index) {
+        unsigned oldSize = dirty_.Size();
+        shownValues_.Resize(index + 1);
+        dirty_.Resize(index + 1);
+        for (unsigned i = oldSize; i < dirty_.Size(); ++i) {
+            dirty_[i] = false;
+        }
+    }
+    dirty_[index] = false;
+
+    // The editors only say which element changed, each holds its "Index" var
+    PODVector<UIElement*> widgets;
+    binding_->GetValueWidgets(index, widgets);
+    for (unsigned i = 0; i < widgets.Size(); ++i) {
+        SubscribeToEvent(widgets[i], E_TEXTFINISHED, HANDLER(AttributeEditorPanel, HandleEdited));
+        SubscribeToEvent(widgets[i], E_TOGGLED, HANDLER(AttributeEditorPanel, HandleEdited));
+        SubscribeToEvent(widgets[i], E_ITEMSELECTED, HANDLER(AttributeEditorPanel, HandleEdited));
+
+        UIElement* slider = widgets[i]->GetChild(String(AttributeEditor::DRAG_SLIDER_NAME));
+        if (slider) {
+            SubscribeToEvent(slider, E_DRAGBEGIN, HANDLER(AttributeEditorPanel, HandleDragBegin));
+            SubscribeToEvent(slider, E_DRAGMOVE, HANDLER(AttributeEditorPanel, HandleDragMove));
+            SubscribeToEvent(slider, E_DRAGEND, HANDLER(AttributeEditorPanel, HandleDragEnd));
+            SubscribeToEvent(slider, E_DRAGCANCEL, HANDLER(AttributeEditorPanel, HandleDragCancel));
+        }
+    }
+
+    Serializable* target = target_;
+    if (target) {
+        ShowValue(index, target->GetAttribute(index));
+    }
+    return true;
+}
+
+void AttributeEditorPanel::Clear()
+{
+    UnsubscribeFromAllEvents();
+    coalescer_->FlushAll();
+    dragEdit_.Reset();
+
+    if (pool_) {
+        UIElement* container = container_;
+        ListView* list = container && container->GetType() == ListView::GetTypeStatic() ? static_cast<ListView*>(container) : 0;
+        unsigned numBound = binding_->GetNumBound();
+        for (unsigned i = 0; i < numBound; ++i) {
+            UIElement* editor = binding_->GetEditor(binding_->GetBoundIndex(i));
+            // Only the ones Populate made, editors given to AddEditor are the caller's
+            if (editor->GetVar("Shape").IsEmpty() || editor->GetParent() != (list ? list->GetContentElement() : container)) continue;
+            if (list)
+                list->RemoveItem(editor);
+            pool_->Release(editor);
+        }
+    }
+    container_.Reset();
+
+    binding_->Clear();
+    shownValues_.Clear();
+    dirty_.Clear();
+    dirtyList_.Clear();
+}
+
+unsigned AttributeEditorPanel::Apply()
+{
+    // Taken first, listeners of the commits may edit again
+    PODVector<unsigned> indices(dirtyList_);
+    ClearDirty();
+
+    Serializable* target = target_;
+    if (!target) {
+        return 0;
+    }
+
+    unsigned written = 0;
+    Vector<Variant> oldValues;
+    oldValues.Resize(indices.Size());
+    for (unsigned i = 0; i < indices.Size(); ++i) {
+        unsigned index = indices[i];
+        oldValues[i] = target->GetAttribute(index);
+        Variant value = binding_->GetValue(index, oldValues[i]);
+        if (value != oldValues[i]) {
+            target->SetAttribute(index, value);
+            ++written;
+        }
+        shownValues_[index] = value;
+    }
+
+    if (written) {
+        target->ApplyAttributes();
+        for (unsigned i = 0; i < indices.Size(); ++i) {
+            if (shownValues_[indices[i]] != oldValues[i]) {
+                SendEditCommitted(indices[i], oldValues[i], shownValues_[indices[i]]);
+            }
+        }
+    }
+    return written;
+}
+
+unsigned AttributeEditorPanel::Refresh()
+{
+    Serializable* target = target_;
+    if (!target) {
+        return 0;
+    }
+
+    unsigned updated = 0;
+    unsigned numBound = binding_->GetNumBound();
+    for (unsigned i = 0; i < numBound; ++i) {
+        unsigned index = binding_->GetBoundIndex(i);
+        if (dirty_[index] || (dragEdit_ && dragIndex_ == index)) continue;
+
+        Variant value = target->GetAttribute(index);
+        if (value != shownValues_[index]) {
+            ShowValue(index, value);
+            ++updated;
+        }
+    }
+    return updated;
+}
+
+void AttributeEditorPanel::Revert()
+{
+    ClearDirty();
+
+    Serializable* target = target_;
+    if (!target) {
+        return;
+    }
+
+    unsigned numBound = binding_->GetNumBound();
+    for (unsigned i = 0; i < numBound; ++i) {
+        unsigned index = binding_->GetBoundIndex(i);
+        ShowValue(index, target->GetAttribute(index));
+    }
+}
+
+void AttributeEditorPanel::CommitWritten(unsigned int index, const Variant& oldValue)
+{
+    Serializable* target = target_;
+    if (!target) {
+        return;
+    }
+
+    Variant value = target->GetAttribute(index);
+    if (binding_->IsBound(index)) {
+        if (dirty_[index]) {
+            dirty_[index] = false;
+            dirtyList_.Remove(index);
+        }
+        // A drag of it would otherwise write its own value over this one
+        if (dragEdit_ && dragIndex_ == index) {
+            coalescer_->Cancel(target, index);
+            dragEdit_.Reset();
+        }
+        ShowValue(index, value);
+    }
+    if (value != oldValue) {
+        SendEditCommitted(index, oldValue, value);
+    }
+}
+
+bool AttributeEditorPanel::IsDirty(unsigned int index) const
+{
+    return index < dirty_.Size() && dirty_[index];
+}
+
+void AttributeEditorPanel::ShowValue(unsigned int index, const Variant& value)
+{
+    // Checkboxes and dropdowns send Toggled and ItemSelected for any change,
+    // not only the user's, those of our own writes are not edits
+    showing_ = true;
+    binding_->SetValue(index, value);
+    showing_ = false;
+    shownValues_[index] = value;
+}
+
+void AttributeEditorPanel::MarkDirty(unsigned int index)
+{
+    if (index >= dirty_.Size() || !binding_->IsBound(index)) {
+        return;
+    }
+    if (!dirty_[index]) {
+        dirty_[index] = true;
+        dirtyList_.Push(index);
+    }
+}
+
+void AttributeEditorPanel::ClearDirty()
+{
+    for (unsigned i = 0; i < dirtyList_.Size(); ++i) {
+        dirty_[dirtyList_[i]] = false;
+    }
+    dirtyList_.Clear();
+}
+
+void AttributeEditorPanel::HandleEdited(StringHash eventType, VariantMap& eventData)
+{
+    // P_ELEMENT is shared by TextFinished, Toggled and ItemSelected
+    using namespace TextFinished;
+
+    UIElement* element = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+    if (!element || showing_) {
+        return;
+    }
+
+    MarkDirty(element->GetVar("Index").GetUInt());
+    if (autoApply_) {
+        Apply();
+    }
+}
+
+void AttributeEditorPanel::HandleDragBegin(StringHash eventType, VariantMap& eventData)
+{
+    using namespace DragBegin;
+
+    UIElement* slider = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+    UIElement* parent = slider ? slider->GetParent() : 0;
+    Serializable* target = target_;
+    if (!parent || parent->GetType() != LineEdit::GetTypeStatic() || !target) {
+        return;
+    }
+
+    LineEdit* edit = static_cast<LineEdit*>(parent);
+    dragEdit_ = edit;
+    dragIndex_ = edit->GetVar("Index").GetUInt();
+    dragBase_ = ToFloat(edit->GetText());
+    dragDelta_ = 0;
+    dragOldValue_ = target->GetAttribute(dragIndex_);
+}
+
+void AttributeEditorPanel::HandleDragMove(StringHash eventType, VariantMap& eventData)
+{
+    using namespace DragMove;
+
+    LineEdit* edit = dragEdit_;
+    Serializable* target = target_;
+    if (!edit || !target) {
+        return;
+    }
+
+    dragDelta_ += eventData[P_DX].GetInt();
+    edit->SetText(String(dragBase_ + dragDelta_ * dragSensitivity_));
+
+    // Parsed and shown back so int coordinates show as ints, the write itself
+    // waits for the coalescer
+    Variant value = binding_->GetValue(dragIndex_, dragOldValue_);
+    ShowValue(dragIndex_, value);
+    coalescer_->Queue(target, dragIndex_, value);
+}
+
+void AttributeEditorPanel::HandleDragEnd(StringHash eventType, VariantMap& eventData)
+{
+    Serializable* target = target_;
+    if (!dragEdit_ || !target) {
+        dragEdit_.Reset();
+        return;
+    }
+    dragEdit_.Reset();
+
+    coalescer_->Flush(target, dragIndex_);
+    Variant value = target->GetAttribute(dragIndex_);
+    shownValues_[dragIndex_] = value;
+    if (value != dragOldValue_) {
+        SendEditCommitted(dragIndex_, dragOldValue_, value);
+    }
+}
+
+void AttributeEditorPanel::HandleDragCancel(StringHash eventType, VariantMap& eventData)
+{
+    Serializable* target = target_;
+    if (!dragEdit_ || !target) {
+        dragEdit_.Reset();
+        return;
+    }
+    dragEdit_.Reset();
+
+    // Put back what was there before the drag, nothing is committed
+    coalescer_->Cancel(target, dragIndex_);
+    if (target->GetAttribute(dragIndex_) != dragOldValue_) {
+        target->SetAttribute(dragIndex_, dragOldValue_);
+        target->ApplyAttributes();
+    }
+    ShowValue(dragIndex_, dragOldValue_);
+}
+
+void AttributeEditorPanel::SendEditCommitted(unsigned int index, const Variant& oldValue, const Variant& newValue)
+{
+    using namespace AttributeEditCommitted;
+
+    VariantMap& eventData = context_->GetEventDataMap();
+    eventData[P_SERIALIZABLE] = target_.Get();
+    eventData[P_INDEX] = index;
+    eventData[P_OLDVALUE] = oldValue;
+    eventData[P_NEWVALUE] = newValue;
+    SendEvent(E_ATTRIBUTEEDITCOMMITTED, eventData);
+}
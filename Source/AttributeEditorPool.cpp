@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeEditorPool.hpp"
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+
+#include <Urho3D/Core/Attribute.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/UI/UIElement.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+AttributeEditorPool::AttributeEditorPool(Context* context, XMLFile* style)
+    : Object(context)
+    , style_(style)
+{
+}
+
+AttributeEditorPool::~AttributeEditorPool()
+{
+}
+
+void AttributeEditorPool::SetStyle(XMLFile* style)
+{
+    if (style != style_) {
+        pool_.Clear();
+        style_ = style;
+    }
+}
+
+XMLFile* AttributeEditorPool::GetStyle() const
+{
+    return style_;
+}
+
+SharedPtr<UIElement> AttributeEditorPool::Checkout(const AttributeInfo& info, unsigned int index, unsigned int subIndex)
+{
+    StringHash shape = AttributeEditor::GetAttributeEditorShape(info);
+
+    HashMap<StringHash, EditorList>::Iterator i = pool_.Find(shape);
+    if (i != pool_.End() && !i->second_.Empty()) {
+        SharedPtr<UIElement> editor = i->second_.Back();
+        i->second_.Pop();
+        AttributeEditor::RebindAttributeEditor(editor, info, index, subIndex);
+        return editor;
+    }
+
+    SharedPtr<UIElement> editor(AttributeEditor::CreateAttributeEditor(context_, style_, info, index, subIndex));
+    if (editor) {
+        editor->SetVar("Shape", shape);
+    }
+    return editor;
+}
+
+void AttributeEditorPool::Release(UIElement* editor)
+{
+    if (!editor) {
+        return;
+    }
+
+    const Variant& shape = editor->GetVar("Shape");
+    if (shape.IsEmpty()) {
+        throw "Tried to release an attribute editor that did not come from a pool";
+    }
+
+    // Keep it alive while it is taken out of the UI
+    SharedPtr<UIElement> keep(editor);
+    editor->Remove();
+    pool_[shape.GetStringHash()].Push(keep);
+}
+
+void AttributeEditorPool::Prewarm(const AttributeInfo& info, unsigned count)
+{
+    StringHash shape = AttributeEditor::GetAttributeEditorShape(info);
+    EditorList& editors = pool_[shape];
+    while (editors.Size() < count) {
+        SharedPtr<UIElement> editor(AttributeEditor::CreateAttributeEditor(context_, style_, info, 0, 0));
+        if (!editor) {
+            return;
+        }
+        editor->SetVar("Shape", shape);
+        editors.Push(editor);
+    }
+}
+
+void AttributeEditorPool::Clear()
+{
+    pool_.Clear();
+}
+
+unsigned AttributeEditorPool::GetNumPooled(const AttributeInfo& info) const
+{
+    HashMap<StringHash, EditorList>::ConstIterator i = pool_.Find(AttributeEditor::GetAttributeEditorShape(info));
+    return i != pool_.End() ? i->second_.Size() : 0;
+}
+
+unsigned AttributeEditorPool::GetNumPooled() const
+{
+    unsigned count = 0;
+    for (HashMap<StringHash, EditorList>::ConstIterator i = pool_.Begin(); i != pool_.End(); ++i) {
+        count += i->second_.Size();
+    }
+    return count;
+}
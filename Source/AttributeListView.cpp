@@ -0,0 +1,332 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeListView.hpp"
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+
+#include <Urho3D/Core/Attribute.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Scene/Serializable.h>
+#include <Urho3D/UI/ListView.h>
+#include <Urho3D/UI/UI.h>
+#include <Urho3D/UI/UIElement.h>
+#include <Urho3D/UI/UIEvents.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+AttributeListView::AttributeListView(Context* context)
+    : Object(context)
+    , firstRow_(0)
+    , pool_(new AttributeEditorPool(context))
+    , updating_(false)
+{
+}
+
+AttributeListView::~AttributeListView()
+{
+    ReleaseAll();
+}
+
+void AttributeListView::SetListView(ListView* view, XMLFile* style)
+{
+    ReleaseAll();
+    ListView* oldView = view_;
+    if (oldView) {
+        UnsubscribeFromEvent(oldView, E_VIEWCHANGED);
+        UnsubscribeFromEvent(oldView, E_RESIZED);
+        oldView->RemoveItem(topSpacer_);
+        oldView->RemoveItem(bottomSpacer_);
+    }
+    view_ = view;
+    style_ = style;
+    pool_->SetStyle(style);
+    if (!view) {
+        return;
+    }
+
+    if (!topSpacer_) {
+        topSpacer_ = new UIElement(context_);
+        bottomSpacer_ = new UIElement(context_);
+    }
+    topSpacer_->SetFixedHeight(0);
+    bottomSpacer_->SetFixedHeight(0);
+
+    view->RemoveAllItems();
+    view->AddItem(topSpacer_);
+    view->AddItem(bottomSpacer_);
+    SubscribeToEvent(view, E_VIEWCHANGED, HANDLER(AttributeListView, HandleViewChanged));
+    SubscribeToEvent(view, E_RESIZED, HANDLER(AttributeListView, HandleViewChanged));
+
+    UpdateWindow(true);
+}
+
+ListView* AttributeListView::GetListView() const
+{
+    return view_;
+}
+
+void AttributeListView::SetPool(AttributeEditorPool* pool)
+{
+    if (!pool || pool == pool_) {
+        return;
+    }
+    ReleaseAll();
+    pool_ = pool;
+    pool_->SetStyle(style_);
+    UpdateWindow(true);
+}
+
+void AttributeListView::SetTarget(Serializable* target)
+{
+    targets_.Clear();
+    if (target) {
+        targets_.Push(WeakPtr<Serializable>(target));
+    }
+    RebuildRows();
+}
+
+void AttributeListView::SetTargets(const PODVector<Serializable*>& targets)
+{
+    targets_.Clear();
+    for (unsigned i = 0; i < targets.Size(); ++i) {
+        targets_.Push(WeakPtr<Serializable>(targets[i]));
+    }
+    RebuildRows();
+}
+
+void AttributeListView::AddTarget(Serializable* target)
+{
+    targets_.Push(WeakPtr<Serializable>(target));
+    RebuildRows();
+}
+
+void AttributeListView::ClearTargets()
+{
+    targets_.Clear();
+    RebuildRows();
+}
+
+Serializable* AttributeListView::GetTarget(unsigned int subIndex) const
+{
+    return subIndex < targets_.Size() ? targets_[subIndex].Get() : 0;
+}
+
+void AttributeListView::Refresh()
+{
+    UI* ui = GetSubsystem<UI>();
+    UIElement* focus = ui ? ui->GetFocusElement() : 0;
+
+    for (unsigned i = 0; i < editors_.Size(); ++i) {
+        UIElement* editor = editors_[i];
+        if (focus && (focus == editor || focus->IsChildOf(editor))) continue;
+        FillEditor(editor, rows_[firstRow_ + i]);
+    }
+}
+
+void AttributeListView::RebuildRows()
+{
+    ReleaseAll();
+    rows_.Clear();
+
+    for (unsigned i = 0; i < targets_.Size(); ++i) {
+        Serializable* target = targets_[i];
+        const Vector<AttributeInfo>* attrs = target ? target->GetAttributes() : 0;
+        if (!attrs) continue;
+
+        for (unsigned j = 0; j < attrs->Size(); ++j) {
+            if (attrs->At(j).mode_ & AM_NOEDIT) continue;
+            Row row;
+            row.subIndex_ = i;
+            row.index_ = j;
+            rows_.Push(row);
+        }
+    }
+
+    UpdateWindow(true);
+}
+
+void AttributeListView::UpdateWindow(bool force)
+{
+    ListView* view = view_;
+    if (!view || updating_) {
+        return;
+    }
+    // Resizing the spacers moves the view, which would land back here
+    updating_ = true;
+
+    const unsigned rowHeight = AttributeEditor::ATTR_HEIGHT;
+    unsigned viewY = (unsigned)Max(view->GetViewPosition().y_, 0);
+    UIElement* panel = view->GetScrollPanel();
+    unsigned viewHeight = (unsigned)Max(panel ? panel->GetHeight() : view->GetHeight(), 0);
+
+    // One extra row each for the partly shown rows at the top and bottom
+    unsigned first = Min(viewY / rowHeight, rows_.Size());
+    unsigned end = Min(first + viewHeight / rowHeight + 2, rows_.Size());
+
+    if (!force && first == firstRow_ && end == firstRow_ + editors_.Size()) {
+        updating_ = false;
+        return;
+    }
+
+    // Rows still in view keep their editor, the rest go back to the pool
+    Vector<SharedPtr<UIElement> > editors;
+    editors.Resize(end - first);
+    for (unsigned i = 0; i < editors_.Size(); ++i) {
+        unsigned row = firstRow_ + i;
+        if (!force && row >= first && row < end) {
+            editors[row - first] = editors_[i];
+        } else {
+            view->RemoveItem(editors_[i]);
+            Release(editors_[i]);
+        }
+    }
+    editors_ = editors;
+    firstRow_ = first;
+
+    // Item 0 is the top spacer, and every row before j is already in place
+    for (unsigned j = 0; j < editors_.Size(); ++j) {
+        if (editors_[j]) continue;
+        editors_[j] = Checkout(rows_[first + j]);
+        FillEditor(editors_[j], rows_[first + j]);
+        view->InsertItem(1 + j, editors_[j]);
+    }
+
+    topSpacer_->SetFixedHeight(first * rowHeight);
+    bottomSpacer_->SetFixedHeight((rows_.Size() - end) * rowHeight);
+
+    updating_ = false;
+}
+
+void AttributeListView::ReleaseAll()
+{
+    ListView* view = view_;
+    for (unsigned i = 0; i < editors_.Size(); ++i) {
+        if (view) {
+            view->RemoveItem(editors_[i]);
+        }
+        Release(editors_[i]);
+    }
+    editors_.Clear();
+    firstRow_ = 0;
+}
+
+SharedPtr<UIElement> AttributeListView::Checkout(const Row& row)
+{
+    Serializable* target = GetTarget(row.subIndex_);
+    SharedPtr<UIElement> editor;
+    if (target) {
+        const AttributeInfo& info = target->GetAttributes()->At(row.index_);
+        editor = pool_->Checkout(info, row.index_, row.subIndex_);
+        if (!editor) {
+            // No editor for the type, show the name alone, it is not pooled
+            editor = AttributeEditor::CreateAttributeEditorParent(context_, style_, info.name_, row.index_, row.subIndex_);
+        }
+    } else {
+        // Gone since the rows were built, keep the row height with an empty row
+        editor = AttributeEditor::CreateAttributeEditorParent(context_, style_, String::EMPTY, row.index_, row.subIndex_);
+    }
+
+    SubscribeToEditor(editor, true);
+    return editor;
+}
+
+void AttributeListView::Release(UIElement* editor)
+{
+    if (!editor) {
+        return;
+    }
+    SubscribeToEditor(editor, false);
+    if (!editor->GetVar("Shape").IsEmpty()) {
+        pool_->Release(editor);
+    }
+}
+
+void AttributeListView::SubscribeToEditor(UIElement* editor, bool subscribe)
+{
+    // A pooled editor may be checked out by another view next, so it is only
+    // listened to while it is a row here
+    PODVector<UIElement*> widgets;
+    UIElement* value = editor->GetChild(1);
+    if (value && value->GetType() == UIElement::GetTypeStatic()) {
+        value->GetChildren(widgets);
+    } else if (value) {
+        widgets.Push(value);
+    }
+
+    for (unsigned i = 0; i < widgets.Size(); ++i) {
+        if (subscribe) {
+            SubscribeToEvent(widgets[i], E_TEXTFINISHED, HANDLER(AttributeListView, HandleEdited));
+            SubscribeToEvent(widgets[i], E_TOGGLED, HANDLER(AttributeListView, HandleEdited));
+            SubscribeToEvent(widgets[i], E_ITEMSELECTED, HANDLER(AttributeListView, HandleEdited));
+        } else {
+            UnsubscribeFromEvents(widgets[i]);
+        }
+    }
+}
+
+void AttributeListView::FillEditor(UIElement* editor, const Row& row)
+{
+    Serializable* target = GetTarget(row.subIndex_);
+    UIElement* value = editor->GetChild(1);
+    if (target && value) {
+        AttributeEditor::SetValue(value, target->GetAttribute(row.index_));
+    }
+}
+
+void AttributeListView::HandleViewChanged(StringHash eventType, VariantMap& eventData)
+{
+    UpdateWindow(false);
+}
+
+void AttributeListView::HandleEdited(StringHash eventType, VariantMap& eventData)
+{
+    // P_ELEMENT is shared by TextFinished, Toggled and ItemSelected
+    using namespace TextFinished;
+
+    UIElement* element = static_cast<UIElement*>(eventData[P_ELEMENT].GetPtr());
+    if (!element) {
+        return;
+    }
+
+    unsigned index = element->GetVar("Index").GetUInt();
+    Serializable* target = GetTarget(element->GetVar("SubIndex").GetUInt());
+    if (!target) {
+        return;
+    }
+
+    // A coordinate is read back through its container
+    if (!element->GetVar("Coordinate").IsEmpty()) {
+        element = element->GetParent();
+    }
+
+    Variant origValue = target->GetAttribute(index);
+    Variant value = AttributeEditor::GetValue(origValue, element);
+    if (value != origValue) {
+        target->SetAttribute(index, value);
+        target->ApplyAttributes();
+    }
+}
@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeSnapshot.hpp"
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+#include "Urho3D-OverLib/AttributeEditorPanel.hpp"
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Scene/Serializable.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+/// Newest version of the format this reads and the one it writes
+static const unsigned SNAPSHOT_VERSION = 1;
+
+static bool IsSnapshotAttribute(const AttributeInfo& info)
+{
+    if (info.mode_ & AM_NOEDIT) {
+        return false;
+    }
+    // Pointers mean nothing once saved
+    return info.type_ != VAR_NONE && info.type_ != VAR_VOIDPTR && info.type_ != VAR_PTR;
+}
+
+AttributeSnapshot::AttributeSnapshot(Context* context)
+    : Object(context)
+    , valuesOffset_(0)
+    , mode_(SNAPSHOT_FULL)
+{
+    Clear();
+}
+
+AttributeSnapshot::~AttributeSnapshot()
+{
+}
+
+void AttributeSnapshot::Capture(Serializable* source, AttributeSnapshotMode mode)
+{
+    PODVector<Entry> entries;
+    VectorBuffer values;
+    const Vector<AttributeInfo>* attrs = source ? source->GetAttributes() : 0;
+    if (attrs) {
+        for (unsigned i = 0; i < attrs->Size(); ++i) {
+            const AttributeInfo& info = attrs->At(i);
+            if (!IsSnapshotAttribute(info)) continue;
+
+            Variant value = source->GetAttribute(i);
+            if (mode == SNAPSHOT_DIFF && value == info.defaultValue_) continue;
+
+            Entry entry;
+            entry.nameHash_ = StringHash(info.name_).Value();
+            entry.offset_ = values.GetPosition();
+            entries.Push(entry);
+            values.WriteVariant(value);
+        }
+    }
+    Build(mode, entries, values);
+}
+
+unsigned AttributeSnapshot::Apply(Serializable* target, AttributeEditor::Binding* binding) const
+{
+    return Write(target, binding, 0, 0);
+}
+
+unsigned AttributeSnapshot::Apply(AttributeEditorPanel* panel) const
+{
+    Serializable* target = panel ? panel->GetTarget() : 0;
+    PODVector<unsigned> indices;
+    Vector<Variant> oldValues;
+    unsigned written = Write(target, 0, &indices, &oldValues);
+
+    // After ApplyAttributes, as the panel's own Apply sends its commits
+    for (unsigned i = 0; i < indices.Size(); ++i) {
+        panel->CommitWritten(indices[i], oldValues[i]);
+    }
+    return written;
+}
+
+unsigned AttributeSnapshot::Write(Serializable* target, AttributeEditor::Binding* binding, PODVector<unsigned>* indices, Vector<Variant>* oldValues) const
+{
+    const Vector<AttributeInfo>* attrs = target ? target->GetAttributes() : 0;
+    if (!attrs) {
+        return 0;
+    }
+
+    unsigned written = 0;
+    for (unsigned i = 0; i < attrs->Size(); ++i) {
+        const AttributeInfo& info = attrs->At(i);
+        if (!IsSnapshotAttribute(info)) continue;
+
+        Variant value;
+        unsigned entry = FindEntry(info.name_);
+        if (entry != M_MAX_UNSIGNED) {
+            value = ReadValue(entries_[entry]);
+            // Retyped since it was saved
+            if (value.GetType() != info.type_) continue;
+        }
+        else if (mode_ == SNAPSHOT_DIFF) {
+            value = info.defaultValue_;
+        }
+        else {
+            continue;
+        }
+
+        Variant oldValue = target->GetAttribute(i);
+        if (oldValue != value) {
+            target->SetAttribute(i, value);
+            ++written;
+            if (indices) {
+                indices->Push(i);
+                oldValues->Push(oldValue);
+            }
+        }
+        if (binding && binding->IsBound(i)) {
+            binding->SetValue(i, value);
+        }
+    }
+    if (written) {
+        target->ApplyAttributes();
+    }
+    return written;
+}
+
+void AttributeSnapshot::Clear()
+{
+    Build(SNAPSHOT_FULL, PODVector<Entry>(), VectorBuffer());
+}
+
+bool AttributeSnapshot::Save(Serializer& dest) const
+{
+    return dest.Write(data_.GetData(), data_.GetSize()) == data_.GetSize();
+}
+
+bool AttributeSnapshot::Save(const String& fileName) const
+{
+    File file(context_, fileName, FILE_WRITE);
+    if (!file.IsOpen()) {
+        return false;
+    }
+    return Save(file);
+}
+
+bool AttributeSnapshot::Load(Deserializer& source)
+{
+    data_.SetData(source, source.GetSize() - source.GetPosition());
+    if (!Parse()) {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+bool AttributeSnapshot::Load(const String& fileName)
+{
+    File file(context_, fileName);
+    if (!file.IsOpen()) {
+        Clear();
+        return false;
+    }
+    return Load(file);
+}
+
+bool AttributeSnapshot::HasValue(StringHash nameHash) const
+{
+    return FindEntry(nameHash) != M_MAX_UNSIGNED;
+}
+
+Variant AttributeSnapshot::GetValue(StringHash nameHash) const
+{
+    unsigned entry = FindEntry(nameHash);
+    return entry != M_MAX_UNSIGNED ? ReadValue(entries_[entry]) : Variant::EMPTY;
+}
+
+void AttributeSnapshot::Build(AttributeSnapshotMode mode, const PODVector<Entry>& entries, const VectorBuffer& values)
+{
+    PODVector<Entry> sorted(entries);
+    Sort(sorted.Begin(), sorted.End());
+
+    data_.Clear();
+    data_.WriteFileID("OASN");
+    data_.WriteUInt(SNAPSHOT_VERSION);
+    data_.WriteUByte(mode == SNAPSHOT_DIFF ? 1 : 0);
+    data_.WriteUInt(sorted.Size());
+    for (unsigned i = 0; i < sorted.Size(); ++i) {
+        data_.WriteUInt(sorted[i].nameHash_);
+        data_.WriteUInt(sorted[i].offset_);
+    }
+    data_.Write(values.GetData(), values.GetSize());
+    Parse();
+}
+
+bool AttributeSnapshot::Parse()
+{
+    entries_.Clear();
+    valuesOffset_ = 0;
+    mode_ = SNAPSHOT_FULL;
+
+    MemoryBuffer buffer(data_.GetData(), data_.GetSize());
+    if (buffer.GetSize() < 13 || buffer.ReadFileID() != "OASN") {
+        return false;
+    }
+    unsigned version = buffer.ReadUInt();
+    if (version == 0 || version > SNAPSHOT_VERSION) {
+        return false;
+    }
+    AttributeSnapshotMode mode = buffer.ReadUByte() ? SNAPSHOT_DIFF : SNAPSHOT_FULL;
+    unsigned count = buffer.ReadUInt();
+    if (count > (buffer.GetSize() - buffer.GetPosition()) / 8) {
+        return false;
+    }
+
+    entries_.Resize(count);
+    unsigned valuesSize = buffer.GetSize() - buffer.GetPosition() - count * 8;
+    for (unsigned i = 0; i < count; ++i) {
+        entries_[i].nameHash_ = buffer.ReadUInt();
+        entries_[i].offset_ = buffer.ReadUInt();
+        bool sorted = i == 0 || entries_[i - 1].nameHash_ <= entries_[i].nameHash_;
+        if (!sorted || entries_[i].offset_ >= valuesSize) {
+            entries_.Clear();
+            return false;
+        }
+    }
+    valuesOffset_ = buffer.GetPosition();
+    mode_ = mode;
+    return true;
+}
+
+unsigned AttributeSnapshot::FindEntry(StringHash nameHash) const
+{
+    unsigned hash = nameHash.Value();
+    unsigned low = 0;
+    unsigned high = entries_.Size();
+    while (low < high) {
+        unsigned mid = (low + high) / 2;
+        if (entries_[mid].nameHash_ < hash) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low < entries_.Size() && entries_[low].nameHash_ == hash ? low : M_MAX_UNSIGNED;
+}
+
+Variant AttributeSnapshot::ReadValue(const Entry& entry) const
+{
+    MemoryBuffer values(data_.GetData() + valuesOffset_, data_.GetSize() - valuesOffset_);
+    values.Seek(entry.offset_);
+    return values.ReadVariant();
+}
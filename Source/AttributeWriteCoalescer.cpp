@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/AttributeWriteCoalescer.hpp"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Scene/Serializable.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+AttributeWriteCoalescer::AttributeWriteCoalescer(Context* context)
+    : Object(context)
+    , maxWritesPerSecond_(0.0f)
+{
+}
+
+AttributeWriteCoalescer::~AttributeWriteCoalescer()
+{
+    FlushAll();
+}
+
+void AttributeWriteCoalescer::Queue(Serializable* target, unsigned int index, const Variant& value)
+{
+    if (!target) {
+        return;
+    }
+
+    unsigned i = Find(target, index);
+    if (i == M_MAX_UNSIGNED) {
+        if (writes_.Empty()) {
+            SubscribeToEvent(E_UPDATE, HANDLER(AttributeWriteCoalescer, HandleUpdate));
+        }
+        PendingWrite write;
+        write.target_ = target;
+        write.index_ = index;
+        write.lastWriteTime_ = -M_INFINITY;
+        writes_.Push(write);
+        i = writes_.Size() - 1;
+    }
+
+    writes_[i].value_ = value;
+    writes_[i].dirty_ = true;
+}
+
+void AttributeWriteCoalescer::Flush(Serializable* target, unsigned int index)
+{
+    unsigned i = Find(target, index);
+    if (i != M_MAX_UNSIGNED) {
+        if (writes_[i].dirty_) {
+            Write(writes_[i], GetTime());
+        }
+        Remove(i);
+    }
+}
+
+void AttributeWriteCoalescer::FlushAll()
+{
+    float time = GetTime();
+    for (unsigned i = 0; i < writes_.Size(); ++i) {
+        if (writes_[i].dirty_) {
+            Write(writes_[i], time);
+        }
+    }
+    writes_.Clear();
+    UnsubscribeFromEvent(E_UPDATE);
+}
+
+void AttributeWriteCoalescer::Cancel(Serializable* target, unsigned int index)
+{
+    unsigned i = Find(target, index);
+    if (i != M_MAX_UNSIGNED) {
+        Remove(i);
+    }
+}
+
+bool AttributeWriteCoalescer::IsQueued(Serializable* target, unsigned int index) const
+{
+    return Find(target, index) != M_MAX_UNSIGNED;
+}
+
+unsigned AttributeWriteCoalescer::Find(Serializable* target, unsigned int index) const
+{
+    for (unsigned i = 0; i < writes_.Size(); ++i) {
+        if (writes_[i].index_ == index && writes_[i].target_.Get() == target) {
+            return i;
+        }
+    }
+    return M_MAX_UNSIGNED;
+}
+
+void AttributeWriteCoalescer::Write(PendingWrite& write, float time)
+{
+    write.dirty_ = false;
+    write.lastWriteTime_ = time;
+
+    Serializable* target = write.target_;
+    if (target) {
+        target->SetAttribute(write.index_, write.value_);
+        target->ApplyAttributes();
+    }
+}
+
+void AttributeWriteCoalescer::Remove(unsigned i)
+{
+    writes_.Erase(i);
+    if (writes_.Empty()) {
+        UnsubscribeFromEvent(E_UPDATE);
+    }
+}
+
+float AttributeWriteCoalescer::GetTime() const
+{
+    Time* time = GetSubsystem<Time>();
+    return time ? time->GetElapsedTime() : 0.0f;
+}
+
+void AttributeWriteCoalescer::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    float time = GetTime();
+    float interval = maxWritesPerSecond_ > 0.0f ? 1.0f / maxWritesPerSecond_ : 0.0f;
+
+    for (unsigned i = 0; i < writes_.Size(); ++i) {
+        PendingWrite& write = writes_[i];
+        if (write.dirty_ && time - write.lastWriteTime_ >= interval) {
+            Write(write, time);
+        }
+    }
+}
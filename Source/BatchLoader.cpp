@@ -0,0 +1,289 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Urho3D-OverLib/BatchLoader.hpp"
+#include "Urho3D-OverLib/ResourceScopes.hpp"
+#include "Urho3D-OverLib/ResourceTelemetry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Resource/Resource.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+#include <Urho3D/Resource/XMLFile.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+BatchLoader::BatchLoader(Context* context)
+    : Object(context)
+    , loaded_(0)
+    , failed_(0)
+    , bytes_(0)
+    , started_(false)
+    , dirty_(false)
+    , holdResources_(false)
+{
+}
+
+BatchLoader::~BatchLoader()
+{
+}
+
+void BatchLoader::AddResource(StringHash type, const String& name)
+{
+    if (started_) {
+        throw "Tried to add a resource to a batch that has already been started";
+    }
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    String sanitatedName = cache->SanitateResourceName(name);
+    StringHash nameHash(sanitatedName);
+
+    unsigned newIndex = entries_.Size();
+    HashMap<StringHash, unsigned>::Iterator i = nameToEntry_.Find(nameHash);
+    if (i != nameToEntry_.End()) {
+        unsigned last = i->second_;
+        for (;;) {
+            if (entries_[last].type_ == type) {
+                return; // Already in the batch
+            }
+            if (entries_[last].nextSameName_ == M_MAX_UNSIGNED) {
+                break;
+            }
+            last = entries_[last].nextSameName_;
+        }
+        entries_[last].nextSameName_ = newIndex;
+    } else {
+        nameToEntry_[nameHash] = newIndex;
+    }
+
+    Entry entry;
+    entry.type_ = type;
+    entry.name_ = sanitatedName;
+    entry.state_ = ENTRY_WAITING;
+    entry.nextSameName_ = M_MAX_UNSIGNED;
+    entries_.Push(entry);
+}
+
+bool BatchLoader::AddManifest(XMLFile* manifest)
+{
+    if (!manifest) {
+        return false;
+    }
+
+    XMLElement root = manifest->GetRoot();
+    if (root.IsNull()) {
+        LOGWARNING("Resource manifest has no root element: " + manifest->GetName());
+        return false;
+    }
+
+    for (XMLElement resource = root.GetChild("resource"); resource.NotNull(); resource = resource.GetNext("resource")) {
+        const String& type = resource.GetAttribute("type");
+        const String& name = resource.GetAttribute("name");
+        if (type.Empty() || name.Empty()) {
+            LOGWARNING("Skipping resource manifest entry lacking a type or name in: " + manifest->GetName());
+            continue;
+        }
+        AddResource(StringHash(type), name);
+    }
+    return true;
+}
+
+bool BatchLoader::AddManifest(const String& manifestName)
+{
+    return AddManifest(GetSubsystem<ResourceCache>()->GetResource<XMLFile>(manifestName));
+}
+
+void BatchLoader::Start()
+{
+    if (started_) {
+        throw "Tried to start a batch that has already been started";
+    }
+    started_ = true;
+    dirty_ = true;
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    ResourceTelemetry* telemetry = GetSubsystem<ResourceTelemetry>();
+    ResourceScopes* scopes = GetSubsystem<ResourceScopes>();
+    SubscribeToEvent(cache, E_RESOURCEBACKGROUNDLOADED, HANDLER(BatchLoader, HandleResourceBackgroundLoaded));
+    SubscribeToEvent(E_UPDATE, HANDLER(BatchLoader, HandleUpdate));
+
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        Entry& entry = entries_[i];
+        entry.state_ = ENTRY_PENDING;
+        if (scopes) {
+            scopes->Track(entry.type_, entry.name_);
+        }
+        long long start = telemetry ? telemetry->GetTime() : 0;
+        if (cache->BackgroundLoadResource(entry.type_, entry.name_, false)) {
+            if (telemetry) {
+                telemetry->RecordQueued(entry.type_, entry.name_, start);
+            }
+            // Without threading it was loaded right away and no event comes
+            Resource* resource = cache->GetExistingResource(entry.type_, entry.name_);
+            if (resource) {
+                MarkDone(i, resource);
+            }
+            continue;
+        }
+
+        // Not queued, so it is either already loaded, already queued by
+        // someone else (and its event is still to come), or just missing,
+        // with nothing queued at all it can only have failed to load
+        Resource* resource = cache->GetExistingResource(entry.type_, entry.name_);
+        if (resource) {
+            MarkDone(i, resource);
+            if (telemetry) {
+                telemetry->RecordCacheHit(entry.type_);
+            }
+        } else if (!cache->Exists(entry.name_) || !cache->GetNumBackgroundLoadResources()) {
+            MarkDone(i, 0);
+            if (telemetry) {
+                telemetry->RecordFailure(entry.type_);
+            }
+        }
+    }
+}
+
+float BatchLoader::GetProgress() const
+{
+    if (entries_.Empty()) {
+        return started_ ? 1.0f : 0.0f;
+    }
+    return (float)(loaded_ + failed_) / (float)entries_.Size();
+}
+
+void BatchLoader::SetHoldResources(bool enable)
+{
+    holdResources_ = enable;
+    if (!enable) {
+        for (unsigned i = 0; i < entries_.Size(); ++i) {
+            entries_[i].resource_.Reset();
+        }
+    }
+}
+
+bool BatchLoader::HasResource(StringHash type, const String& name) const
+{
+    String sanitatedName = GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+    HashMap<StringHash, unsigned>::ConstIterator i = nameToEntry_.Find(StringHash(sanitatedName));
+    if (i == nameToEntry_.End()) {
+        return false;
+    }
+    for (unsigned index = i->second_; index != M_MAX_UNSIGNED; index = entries_[index].nextSameName_) {
+        if (entries_[index].type_ == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchLoader::MarkDone(unsigned index, Resource* resource)
+{
+    Entry& entry = entries_[index];
+    if (resource) {
+        entry.state_ = ENTRY_LOADED;
+        if (holdResources_) {
+            entry.resource_ = resource;
+        }
+        ++loaded_;
+        bytes_ += resource->GetMemoryUse();
+    } else {
+        entry.state_ = ENTRY_FAILED;
+        ++failed_;
+    }
+    dirty_ = true;
+}
+
+void BatchLoader::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    HashMap<StringHash, unsigned>::ConstIterator i = nameToEntry_.Find(StringHash(eventData[P_RESOURCENAME].GetString()));
+    if (i == nameToEntry_.End()) {
+        return;
+    }
+
+    Resource* resource = eventData[P_SUCCESS].GetBool() ? static_cast<Resource*>(eventData[P_RESOURCE].GetPtr()) : 0;
+    for (unsigned index = i->second_; index != M_MAX_UNSIGNED; index = entries_[index].nextSameName_) {
+        const Entry& entry = entries_[index];
+        // A failure carries no type so it is given to the first pending entry
+        if (entry.state_ == ENTRY_PENDING && (!resource || resource->GetType() == entry.type_)) {
+            MarkDone(index, resource);
+            break;
+        }
+    }
+}
+
+void BatchLoader::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!dirty_) {
+        return;
+    }
+    dirty_ = false;
+
+    // Nothing of the batch is touched once the event is out, a handler may
+    // well let go of it
+    if (IsComplete()) {
+        UnsubscribeFromAllEvents();
+        SendProgressEvent(E_BATCHLOADCOMPLETE);
+    } else {
+        SendProgressEvent(E_BATCHLOADPROGRESS);
+    }
+}
+
+void BatchLoader::SendProgressEvent(StringHash eventType)
+{
+    // Both events share the same parameter layout
+    using namespace BatchLoadProgress;
+
+    VariantMap& eventData = context_->GetEventDataMap();
+    eventData[P_BATCH] = this;
+    eventData[P_LOADED] = loaded_;
+    eventData[P_FAILED] = failed_;
+    eventData[P_TOTAL] = entries_.Size();
+    eventData[P_BYTES] = bytes_;
+    SendEvent(eventType, eventData);
+}
+
+
+BatchLoadingTask::BatchLoadingTask(BatchLoader* loader, const String& label)
+    : LoadingTask(label)
+    , loader_(loader)
+{
+}
+
+LoadingTaskResult BatchLoadingTask::Run()
+{
+    if (!loader_) {
+        return LOADING_TASK_DONE;
+    }
+    if (!loader_->IsStarted()) {
+        loader_->Start();
+    }
+    SetProgress(loader_->GetProgress());
+    return loader_->IsComplete() ? LOADING_TASK_DONE : LOADING_TASK_WAIT;
+}
@@ -0,0 +1,328 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/ContainerAttributeEdit.hpp"
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <Urho3D/Core/Attribute.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/UI/CheckBox.h>
+#include <Urho3D/UI/Text.h>
+#include <Urho3D/UI/UIEvents.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+ContainerAttributeEdit::ContainerAttributeEdit(Context* context)
+    : UIElement(context)
+    , type_(VAR_NONE)
+    , expanded_(false)
+    , mixed_(false)
+{
+}
+
+ContainerAttributeEdit::~ContainerAttributeEdit()
+{
+}
+
+void ContainerAttributeEdit::Setup(VariantType type)
+{
+    if (toggle_) {
+        throw "Tried to setup a container attribute editor twice";
+    }
+
+    type_ = type;
+    SetLayout(LM_VERTICAL);
+
+    SharedPtr<UIElement> header(new UIElement(context_));
+    AddChild(header);
+    header->SetLayout(LM_HORIZONTAL);
+    header->SetFixedHeight(AttributeEditor::ATTR_HEIGHT);
+
+    toggle_ = new CheckBox(context_);
+    header->AddChild(toggle_);
+    toggle_->SetStyleAuto();
+
+    summary_ = new Text(context_);
+    header->AddChild(summary_);
+    summary_->SetStyle("EditorAttributeText");
+
+    SubscribeToEvent(toggle_, E_TOGGLED, HANDLER(ContainerAttributeEdit, HandleToggled));
+    UpdateSummary();
+}
+
+void ContainerAttributeEdit::SetValue(const Variant& value)
+{
+    if (value.GetType() != type_) {
+        LOGWARNING("Failed filling in container of the wrong type for: " + GetName());
+        return;
+    }
+
+    bool wasMixed = mixed_;
+    mixed_ = false;
+    toggle_->SetEnabled(true);
+    if (!wasMixed && value == value_) {
+        return;
+    }
+
+    value_ = value;
+    UpdateSummary();
+    if (expanded_) {
+        RemoveEntries();
+        CreateEntries();
+    }
+}
+
+Variant ContainerAttributeEdit::GetValue(const Variant& toValueWithDefault) const
+{
+    if (mixed_ || toValueWithDefault.GetType() != type_) {
+        return toValueWithDefault;
+    }
+    if (!expanded_) {
+        return value_;
+    }
+
+    Vector<Variant> values;
+    Vector<String> names;
+    GetEntries(values, names);
+    for (unsigned i = 0; i < values.Size() && i < entryValues_.Size(); ++i) {
+        if (entryValues_[i]) {
+            values[i] = AttributeEditor::GetValue(values[i], entryValues_[i]);
+        }
+    }
+
+    switch (type_) {
+    case VAR_VARIANTVECTOR:
+        return Variant(values);
+
+    case VAR_VARIANTMAP: {
+        // GetEntries walks the map in the same order
+        VariantMap map;
+        const VariantMap& oldMap = value_.GetVariantMap();
+        unsigned i = 0;
+        for (VariantMap::ConstIterator j = oldMap.Begin(); j != oldMap.End(); ++j, ++i) {
+            map[j->first_] = values[i];
+        }
+        return Variant(map);
+    }
+
+    case VAR_RESOURCEREFLIST: {
+        ResourceRefList refs(value_.GetResourceRefList().type_);
+        for (unsigned i = 0; i < values.Size(); ++i) {
+            refs.names_.Push(values[i].GetString());
+        }
+        return Variant(refs);
+    }
+
+    case VAR_BUFFER: {
+        PODVector<unsigned char> buffer;
+        const char* hex = values[0].GetString().CString();
+        char* end = 0;
+        for (;;) {
+            unsigned long byte = strtoul(hex, &end, 16);
+            if (end == hex) break;
+            if (byte > 0xff) {
+                LOGWARNING("Ignoring hex edit with a token that is not a byte for: " + GetName());
+                return value_;
+            }
+            buffer.Push((unsigned char)byte);
+            hex = end;
+        }
+        // Anything left that was not read as hex
+        while (*hex == ' ' || *hex == '\t' || *hex == '\n' || *hex == '\r') ++hex;
+        if (*hex) {
+            LOGWARNING("Ignoring hex edit that is not hex for: " + GetName());
+            return value_;
+        }
+        return Variant(buffer);
+    }
+
+    default:
+        return value_;
+    }
+}
+
+void ContainerAttributeEdit::SetMixed()
+{
+    SetExpanded(false);
+    mixed_ = true;
+    toggle_->SetEnabled(false);
+    summary_->SetText(AttributeEditor::STRIKED_OUT);
+}
+
+void ContainerAttributeEdit::SetExpanded(bool enable)
+{
+    if (enable == expanded_ || (enable && mixed_)) {
+        return;
+    }
+
+    if (enable) {
+        expanded_ = true;
+        CreateEntries();
+    } else {
+        // Keep the edits made to the entries before they are thrown away
+        value_ = GetValue(value_);
+        expanded_ = false;
+        RemoveEntries();
+    }
+    toggle_->SetChecked(enable);
+}
+
+void ContainerAttributeEdit::UpdateSummary()
+{
+    switch (type_) {
+    case VAR_VARIANTVECTOR:   summary_->SetText(String(value_.GetVariantVector().Size()) + " items"); break;
+    case VAR_VARIANTMAP:      summary_->SetText(String(value_.GetVariantMap().Size()) + " entries"); break;
+    case VAR_RESOURCEREFLIST: summary_->SetText(String(value_.GetResourceRefList().names_.Size()) + " resources"); break;
+    case VAR_BUFFER:          summary_->SetText(String(value_.GetBuffer().Size()) + " bytes"); break;
+    default:                  summary_->SetText(String::EMPTY); break;
+    }
+}
+
+void ContainerAttributeEdit::CreateEntries()
+{
+    if (!entries_) {
+        entries_ = new UIElement(context_);
+        AddChild(entries_);
+        entries_->SetLayout(LM_VERTICAL);
+    }
+    entries_->SetVisible(true);
+
+    XMLFile* style = GetDefaultStyle();
+    unsigned index = GetVar("Index").GetUInt();
+    unsigned subIndex = GetVar("SubIndex").GetUInt();
+
+    Vector<Variant> values;
+    Vector<String> names;
+    GetEntries(values, names);
+    for (unsigned i = 0; i < values.Size(); ++i) {
+        AttributeInfo info;
+        info.type_ = values[i].GetType();
+        info.name_ = names[i];
+        info.mode_ = AM_DEFAULT;
+
+        SharedPtr<UIElement> editor(AttributeEditor::CreateAttributeEditor(context_, style, info, index, subIndex));
+        UIElement* value = editor ? editor->GetChild(1) : 0;
+        if (!value) {
+            // Not editable, show it read only
+            editor = AttributeEditor::CreateAttributeEditorParent(context_, style, names[i] + " = " + values[i].ToString(), index, subIndex);
+        }
+        entries_->AddChild(editor);
+        entryValues_.Push(value);
+        if (!value) continue;
+
+        AttributeEditor::SetValue(value, values[i]);
+
+        PODVector<UIElement*> widgets;
+        if (value->GetType() == UIElement::GetTypeStatic())
+            value->GetChildren(widgets);
+        else
+            widgets.Push(value);
+        for (unsigned j = 0; j < widgets.Size(); ++j) {
+            SubscribeToEvent(widgets[j], E_TEXTFINISHED, HANDLER(ContainerAttributeEdit, HandleEntryEdited));
+            SubscribeToEvent(widgets[j], E_TOGGLED, HANDLER(ContainerAttributeEdit, HandleEntryEdited));
+            SubscribeToEvent(widgets[j], E_ITEMSELECTED, HANDLER(ContainerAttributeEdit, HandleEntryEdited));
+        }
+    }
+}
+
+void ContainerAttributeEdit::RemoveEntries()
+{
+    // Destroying the editors also drops the subscriptions to them
+    entryValues_.Clear();
+    if (entries_) {
+        entries_->RemoveAllChildren();
+        entries_->SetVisible(false);
+    }
+}
+
+void ContainerAttributeEdit::GetEntries(Vector<Variant>& values, Vector<String>& names) const
+{
+    switch (type_) {
+    case VAR_VARIANTVECTOR: {
+        const VariantVector& vector = value_.GetVariantVector();
+        for (unsigned i = 0; i < vector.Size(); ++i) {
+            values.Push(vector[i]);
+            names.Push("[" + String(i) + "]");
+        }
+        break;
+    }
+
+    case VAR_VARIANTMAP: {
+        const VariantMap& map = value_.GetVariantMap();
+        for (VariantMap::ConstIterator i = map.Begin(); i != map.End(); ++i) {
+            values.Push(i->second_);
+            names.Push(i->first_.ToString());
+        }
+        break;
+    }
+
+    case VAR_RESOURCEREFLIST: {
+        const StringVector& refNames = value_.GetResourceRefList().names_;
+        for (unsigned i = 0; i < refNames.Size(); ++i) {
+            values.Push(Variant(refNames[i]));
+            names.Push("[" + String(i) + "]");
+        }
+        break;
+    }
+
+    case VAR_BUFFER: {
+        const PODVector<unsigned char>& buffer = value_.GetBuffer();
+        String hex;
+        hex.Reserve(buffer.Size() * 3);
+        char byte[4];
+        for (unsigned i = 0; i < buffer.Size(); ++i) {
+            sprintf(byte, i ? " %02x" : "%02x", buffer[i]);
+            hex += byte;
+        }
+        values.Push(Variant(hex));
+        names.Push("Hex");
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void ContainerAttributeEdit::HandleToggled(StringHash eventType, VariantMap& eventData)
+{
+    SetExpanded(toggle_->IsChecked());
+}
+
+void ContainerAttributeEdit::HandleEntryEdited(StringHash eventType, VariantMap& eventData)
+{
+    // Listeners of the container only know about the container
+    using namespace TextFinished;
+
+    VariantMap& newEventData = GetEventDataMap();
+    newEventData[P_ELEMENT] = this;
+    newEventData[P_TEXT] = summary_->GetText();
+    SendEvent(E_TEXTFINISHED, newEventData);
+}
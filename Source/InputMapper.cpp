@@ -0,0 +1,449 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/InputMapper.hpp"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Input/Input.h>
+#include <Urho3D/Input/InputEvents.h>
+#include <Urho3D/Math/MathDefs.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+InputContext::InputContext(const String& name)
+    : name_(name)
+    , blocking_(false)
+    , version_(0)
+{
+}
+
+InputContext::~InputContext()
+{
+}
+
+void InputContext::Bind(StringHash action, const InputBinding& binding)
+{
+    ActionBinding entry;
+    entry.action_ = action;
+    entry.binding_ = binding;
+    bindings_.Push(entry);
+    ++version_;
+}
+
+void InputContext::BindKey(StringHash action, int key, int chordKey, int chordKey2)
+{
+    InputBinding binding;
+    binding.type_ = BINDING_KEY;
+    binding.code_ = key;
+    binding.joystickId_ = 0;
+    binding.scale_ = 1.0f;
+    binding.deadZone_ = 0.0f;
+    binding.chordKeys_[0] = chordKey;
+    binding.chordKeys_[1] = chordKey2;
+    Bind(action, binding);
+}
+
+void InputContext::BindMouseButton(StringHash action, int button)
+{
+    InputBinding binding;
+    binding.type_ = BINDING_MOUSEBUTTON;
+    binding.code_ = button;
+    binding.joystickId_ = 0;
+    binding.scale_ = 1.0f;
+    binding.deadZone_ = 0.0f;
+    binding.chordKeys_[0] = 0;
+    binding.chordKeys_[1] = 0;
+    Bind(action, binding);
+}
+
+void InputContext::BindJoystickButton(StringHash action, int button, int joystickId)
+{
+    InputBinding binding;
+    binding.type_ = BINDING_JOYSTICKBUTTON;
+    binding.code_ = button;
+    binding.joystickId_ = joystickId;
+    binding.scale_ = 1.0f;
+    binding.deadZone_ = 0.0f;
+    binding.chordKeys_[0] = 0;
+    binding.chordKeys_[1] = 0;
+    Bind(action, binding);
+}
+
+void InputContext::BindJoystickAxis(StringHash action, int axis, float scale, float deadZone, int joystickId)
+{
+    InputBinding binding;
+    binding.type_ = BINDING_JOYSTICKAXIS;
+    binding.code_ = axis;
+    binding.joystickId_ = joystickId;
+    binding.scale_ = scale;
+    binding.deadZone_ = deadZone;
+    binding.chordKeys_[0] = 0;
+    binding.chordKeys_[1] = 0;
+    Bind(action, binding);
+}
+
+void InputContext::Unbind(StringHash action)
+{
+    for (unsigned i = bindings_.Size(); i-- > 0;) {
+        if (bindings_[i].action_ == action) {
+            bindings_.Erase(i);
+        }
+    }
+    ++version_;
+}
+
+void InputContext::Clear()
+{
+    bindings_.Clear();
+    ++version_;
+}
+
+void InputContext::SetBlocking(bool enable)
+{
+    blocking_ = enable;
+    ++version_;
+}
+
+
+InputMapper::InputMapper(Context* context)
+    : Object(context)
+    , pressThreshold_(0.5f)
+    , dirty_(false)
+{
+    SubscribeToEvent(E_KEYDOWN, HANDLER(InputMapper, HandleKeyDown));
+    SubscribeToEvent(E_KEYUP, HANDLER(InputMapper, HandleKeyUp));
+    SubscribeToEvent(E_MOUSEBUTTONDOWN, HANDLER(InputMapper, HandleMouseButtonDown));
+    SubscribeToEvent(E_MOUSEBUTTONUP, HANDLER(InputMapper, HandleMouseButtonUp));
+    SubscribeToEvent(E_JOYSTICKBUTTONDOWN, HANDLER(InputMapper, HandleJoystickButtonDown));
+    SubscribeToEvent(E_JOYSTICKBUTTONUP, HANDLER(InputMapper, HandleJoystickButtonUp));
+    SubscribeToEvent(E_JOYSTICKAXISMOVE, HANDLER(InputMapper, HandleJoystickAxisMove));
+    SubscribeToEvent(E_INPUTFOCUS, HANDLER(InputMapper, HandleInputFocus));
+    // The Input subsystem handles the frame's events on its own E_BEGINFRAME,
+    // which it subscribed to first
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(InputMapper, HandleBeginFrame));
+}
+
+InputMapper::~InputMapper()
+{
+}
+
+unsigned InputMapper::RegisterAction(const String& name)
+{
+    return RegisterAction(StringHash(name));
+}
+
+unsigned InputMapper::RegisterAction(StringHash action)
+{
+    HashMap<StringHash, unsigned>::ConstIterator i = actionIndices_.Find(action);
+    if (i != actionIndices_.End()) {
+        return i->second_;
+    }
+
+    unsigned index = actions_.Size();
+    ActionState state;
+    state.value_ = 0.0f;
+    state.down_ = false;
+    state.wasDown_ = false;
+    state.first_ = 0;
+    state.count_ = 0;
+    actions_.Push(state);
+    actionIndices_[action] = index;
+    dirty_ = true;
+    return index;
+}
+
+unsigned InputMapper::GetActionIndex(StringHash action) const
+{
+    HashMap<StringHash, unsigned>::ConstIterator i = actionIndices_.Find(action);
+    return i != actionIndices_.End() ? i->second_ : M_MAX_UNSIGNED;
+}
+
+void InputMapper::PushContext(InputContext* context, Object* owner)
+{
+    if (!context) {
+        return;
+    }
+    ContextEntry entry;
+    entry.context_ = context;
+    entry.owner_ = owner;
+    entry.version_ = context->GetVersion();
+    contexts_.Push(entry);
+    dirty_ = true;
+}
+
+void InputMapper::RemoveContext(InputContext* context)
+{
+    for (unsigned i = contexts_.Size(); i-- > 0;) {
+        if (contexts_[i].context_ == context) {
+            contexts_.Erase(i);
+            dirty_ = true;
+        }
+    }
+}
+
+void InputMapper::RemoveContexts(Object* owner)
+{
+    for (unsigned i = contexts_.Size(); i-- > 0;) {
+        if (contexts_[i].owner_ == owner) {
+            contexts_.Erase(i);
+            dirty_ = true;
+        }
+    }
+}
+
+void InputMapper::SetStateContext(Object* state, InputContext* context)
+{
+    if (!state) {
+        return;
+    }
+    // Swapped straight away for a state that has already started
+    for (unsigned i = 0; i < contexts_.Size(); ++i) {
+        if (contexts_[i].owner_ == state) {
+            contexts_[i].context_ = context;
+            contexts_[i].version_ = context ? context->GetVersion() : 0;
+            dirty_ = true;
+        }
+    }
+    if (!context) {
+        RemoveContexts(state);
+    }
+
+    for (unsigned i = 0; i < stateContexts_.Size(); ++i) {
+        if (stateContexts_[i].state_ == state) {
+            if (context) {
+                stateContexts_[i].context_ = context;
+            } else {
+                stateContexts_.Erase(i);
+            }
+            return;
+        }
+    }
+    if (context) {
+        StateContext entry;
+        entry.state_ = state;
+        entry.context_ = context;
+        stateContexts_.Push(entry);
+    }
+}
+
+InputContext* InputMapper::GetStateContext(Object* state) const
+{
+    for (unsigned i = 0; i < stateContexts_.Size(); ++i) {
+        if (stateContexts_[i].state_ == state) {
+            return stateContexts_[i].context_;
+        }
+    }
+    return 0;
+}
+
+void InputMapper::Sample()
+{
+    for (unsigned i = 0; i < contexts_.Size() && !dirty_; ++i) {
+        dirty_ = contexts_[i].version_ != contexts_[i].context_->GetVersion();
+    }
+    if (dirty_) {
+        Compile();
+    }
+
+    const float* raw = rawInputs_.Buffer();
+    const CompiledBinding* bindings = compiled_.Buffer();
+    for (unsigned i = 0; i < actions_.Size(); ++i) {
+        ActionState& action = actions_[i];
+        float value = 0.0f;
+        for (unsigned j = action.first_, end = action.first_ + action.count_; j < end; ++j) {
+            const CompiledBinding& binding = bindings[j];
+            if ((binding.chordSlots_[0] != M_MAX_UNSIGNED && raw[binding.chordSlots_[0]] == 0.0f) ||
+                (binding.chordSlots_[1] != M_MAX_UNSIGNED && raw[binding.chordSlots_[1]] == 0.0f)) {
+                continue;
+            }
+            float bound = raw[binding.slot_] * binding.scale_;
+            if (Abs(bound) > binding.deadZone_ && Abs(bound) > Abs(value)) {
+                value = bound;
+            }
+        }
+        action.wasDown_ = action.down_;
+        action.value_ = value;
+        action.down_ = Abs(value) >= pressThreshold_;
+    }
+}
+
+void InputMapper::ResetInput()
+{
+    for (unsigned i = 0; i < rawInputs_.Size(); ++i) {
+        rawInputs_[i] = 0.0f;
+    }
+}
+
+void InputMapper::Compile()
+{
+    for (unsigned i = 0; i < contexts_.Size(); ++i) {
+        contexts_[i].version_ = contexts_[i].context_->GetVersion();
+    }
+
+    // Register first so the action ranges can be laid out in one pass
+    for (unsigned i = 0; i < contexts_.Size(); ++i) {
+        InputContext* context = contexts_[i].context_;
+        for (unsigned j = 0; j < context->GetNumBindings(); ++j) {
+            RegisterAction(context->GetBindingAction(j));
+        }
+    }
+
+    // The topmost context binding an action wins, down to a blocking one
+    unsigned bottom = 0;
+    for (unsigned i = contexts_.Size(); i-- > 0;) {
+        if (contexts_[i].context_->IsBlocking()) {
+            bottom = i;
+            break;
+        }
+    }
+
+    compiled_.Clear();
+    for (HashMap<StringHash, unsigned>::ConstIterator a = actionIndices_.Begin(); a != actionIndices_.End(); ++a) {
+        ActionState& action = actions_[a->second_];
+        action.first_ = compiled_.Size();
+        action.count_ = 0;
+
+        for (unsigned i = contexts_.Size(); i-- > bottom && !action.count_;) {
+            InputContext* context = contexts_[i].context_;
+            for (unsigned j = 0; j < context->GetNumBindings(); ++j) {
+                if (context->GetBindingAction(j) != a->first_) {
+                    continue;
+                }
+                const InputBinding& binding = context->GetBinding(j);
+                CompiledBinding compiled;
+                compiled.slot_ = GetRawSlot(binding.type_, binding.code_, binding.joystickId_);
+                for (unsigned k = 0; k < MAX_CHORD_KEYS; ++k) {
+                    compiled.chordSlots_[k] = binding.chordKeys_[k] ? GetRawSlot(BINDING_KEY, binding.chordKeys_[k], 0) : M_MAX_UNSIGNED;
+                }
+                compiled.scale_ = binding.scale_;
+                compiled.deadZone_ = binding.deadZone_;
+                compiled_.Push(compiled);
+                ++action.count_;
+            }
+        }
+    }
+    dirty_ = false;
+}
+
+unsigned InputMapper::GetRawSlot(InputBindingType type, int code, int joystickId)
+{
+    unsigned key = type >= BINDING_JOYSTICKBUTTON ? ((unsigned)joystickId << 16) | (unsigned)code : (unsigned)code;
+    HashMap<unsigned, unsigned>::ConstIterator i = rawSlots_[type].Find(key);
+    if (i != rawSlots_[type].End()) {
+        return i->second_;
+    }
+
+    // Input held since before anything was bound to it is picked up here
+    float value = 0.0f;
+    Input* input = GetSubsystem<Input>();
+    if (input && type == BINDING_KEY) {
+        value = input->GetKeyDown(code) ? 1.0f : 0.0f;
+    } else if (input && type == BINDING_MOUSEBUTTON) {
+        value = input->GetMouseButtonDown(code) ? 1.0f : 0.0f;
+    }
+
+    unsigned slot = rawInputs_.Size();
+    rawInputs_.Push(value);
+    rawSlots_[type][key] = slot;
+    return slot;
+}
+
+void InputMapper::SetRawInput(InputBindingType type, int code, int joystickId, float value)
+{
+    // Kept even while nothing is bound to it, a binding compiled later in the
+    // frame, such as for a synthetic event sent right after a PushContext,
+    // still sees it
+    rawInputs_[GetRawSlot(type, code, joystickId)] = value;
+}
+
+void InputMapper::HandleKeyDown(StringHash eventType, VariantMap& eventData)
+{
+    using namespace KeyDown;
+    SetRawInput(BINDING_KEY, eventData[P_KEY].GetInt(), 0, 1.0f);
+}
+
+void InputMapper::HandleKeyUp(StringHash eventType, VariantMap& eventData)
+{
+    using namespace KeyUp;
+    SetRawInput(BINDING_KEY, eventData[P_KEY].GetInt(), 0, 0.0f);
+}
+
+void InputMapper::HandleMouseButtonDown(StringHash eventType, VariantMap& eventData)
+{
+    using namespace MouseButtonDown;
+    SetRawInput(BINDING_MOUSEBUTTON, eventData[P_BUTTON].GetInt(), 0, 1.0f);
+}
+
+void InputMapper::HandleMouseButtonUp(StringHash eventType, VariantMap& eventData)
+{
+    using namespace MouseButtonUp;
+    SetRawInput(BINDING_MOUSEBUTTON, eventData[P_BUTTON].GetInt(), 0, 0.0f);
+}
+
+void InputMapper::HandleJoystickButtonDown(StringHash eventType, VariantMap& eventData)
+{
+    using namespace JoystickButtonDown;
+    SetRawInput(BINDING_JOYSTICKBUTTON, eventData[P_BUTTON].GetInt(), eventData[P_JOYSTICKID].GetInt(), 1.0f);
+}
+
+void InputMapper::HandleJoystickButtonUp(StringHash eventType, VariantMap& eventData)
+{
+    using namespace JoystickButtonUp;
+    SetRawInput(BINDING_JOYSTICKBUTTON, eventData[P_BUTTON].GetInt(), eventData[P_JOYSTICKID].GetInt(), 0.0f);
+}
+
+void InputMapper::HandleJoystickAxisMove(StringHash eventType, VariantMap& eventData)
+{
+    using namespace JoystickAxisMove;
+    SetRawInput(BINDING_JOYSTICKAXIS, eventData[P_AXIS].GetInt(), eventData[P_JOYSTICKID].GetInt(), eventData[P_POSITION].GetFloat());
+}
+
+void InputMapper::HandleInputFocus(StringHash eventType, VariantMap& eventData)
+{
+    using namespace InputFocus;
+    // Whatever was released while unfocused is never sent
+    if (!eventData[P_FOCUS].GetBool()) {
+        ResetInput();
+    }
+}
+
+void InputMapper::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    Sample();
+}
+
+void InputMapper::StartStateContext(Object* state)
+{
+    InputContext* context = GetStateContext(state);
+    if (context) {
+        RemoveContexts(state);
+        PushContext(context, state);
+    }
+}
+
+void InputMapper::EndStateContext(Object* state)
+{
+    RemoveContexts(state);
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Urho3D-OverLib/LoadingTask.hpp"
+
+#include <Urho3D/Core/Object.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+LoadingTask::LoadingTask(const String& label)
+    : label_(label)
+    , progress_(0.0f)
+    , gateOnly_(false)
+{
+}
+
+LoadingTask::~LoadingTask()
+{
+}
+
+Object* LoadingTask::GetOwner() const
+{
+    return owner_;
+}
+
+
+BackgroundTask::BackgroundTask(const String& label)
+    : label_(label)
+    , submitted_(false)
+    , finished_(false)
+    , cancelled_(false)
+{
+}
+
+BackgroundTask::~BackgroundTask()
+{
+}
+
+void BackgroundTask::Finish()
+{
+}
+
+void BackgroundTask::AddDependency(BackgroundTask* task)
+{
+    if (submitted_) {
+        throw "Tried to add a dependency to a background task that has already started";
+    }
+    if (task && task != this) {
+        dependencies_.Push(SharedPtr<BackgroundTask>(task));
+    }
+}
+
+Object* BackgroundTask::GetOwner() const
+{
+    return owner_;
+}
+
+bool BackgroundTask::IsReady() const
+{
+    for (unsigned i = 0; i < dependencies_.Size(); ++i) {
+        if (!dependencies_[i]->finished_) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BackgroundTask::IsBlocked() const
+{
+    for (unsigned i = 0; i < dependencies_.Size(); ++i) {
+        const BackgroundTask* dependency = dependencies_[i];
+        // Added ones have an owner, one that lost it went with its state
+        if (!dependency->finished_ && (dependency->cancelled_ || !dependency->owner_)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,269 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Urho3D-OverLib/PrefetchScheduler.hpp"
+#include "Urho3D-OverLib/ResourceScopes.hpp"
+#include "Urho3D-OverLib/ResourceTelemetry.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Resource/Resource.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+PrefetchScheduler::PrefetchScheduler(Context* context)
+    : Object(context)
+    , inFlight_(0)
+    , maxInFlight_(16)
+    , nextSequence_(0)
+{
+    for (unsigned i = 0; i < MAX_PREFETCH_PRIORITIES; ++i) {
+        queues_[i].head_ = 0;
+        numQueued_[i] = 0;
+    }
+
+    SubscribeToEvent(E_UPDATE, HANDLER(PrefetchScheduler, HandleUpdate));
+    SubscribeToEvent(GetSubsystem<ResourceCache>(), E_RESOURCEBACKGROUNDLOADED, HANDLER(PrefetchScheduler, HandleResourceBackgroundLoaded));
+}
+
+PrefetchScheduler::~PrefetchScheduler()
+{
+}
+
+StringHash PrefetchScheduler::MakeKey(StringHash type, const String& name)
+{
+    return StringHash(StringHash(name).Value() ^ (type.Value() * 31));
+}
+
+void PrefetchScheduler::Request(StringHash type, const String& name, PrefetchPriority priority)
+{
+    String sanitatedName = GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+    StringHash key = MakeKey(type, sanitatedName);
+
+    HashMap<StringHash, PrefetchRequest>::Iterator i = requests_.Find(key);
+    if (i != requests_.End()) {
+        if (i->second_.state_ == REQUEST_CANCELLED) {
+            // Still loading, so just start tracking it again
+            i->second_.state_ = REQUEST_INFLIGHT;
+        } else if (i->second_.state_ == REQUEST_QUEUED && i->second_.priority_ != priority) {
+            SetPriority(type, sanitatedName, priority);
+        }
+        return;
+    }
+
+    PrefetchRequest& request = requests_[key];
+    request.type_ = type;
+    request.name_ = sanitatedName;
+    request.priority_ = priority;
+    request.state_ = REQUEST_QUEUED;
+    request.sequence_ = nextSequence_++;
+    ++numQueued_[priority];
+    Enqueue(key, priority, request.sequence_);
+}
+
+bool PrefetchScheduler::SetPriority(StringHash type, const String& name, PrefetchPriority priority)
+{
+    StringHash key = MakeKey(type, GetSubsystem<ResourceCache>()->SanitateResourceName(name));
+    HashMap<StringHash, PrefetchRequest>::Iterator i = requests_.Find(key);
+    if (i == requests_.End() || i->second_.state_ != REQUEST_QUEUED) {
+        return false;
+    }
+
+    PrefetchRequest& request = i->second_;
+    if (request.priority_ != priority) {
+        --numQueued_[request.priority_];
+        ++numQueued_[priority];
+        request.priority_ = priority;
+        request.sequence_ = nextSequence_++;
+        Enqueue(key, priority, request.sequence_);
+    }
+    return true;
+}
+
+bool PrefetchScheduler::Cancel(StringHash type, const String& name)
+{
+    StringHash key = MakeKey(type, GetSubsystem<ResourceCache>()->SanitateResourceName(name));
+    HashMap<StringHash, PrefetchRequest>::Iterator i = requests_.Find(key);
+    if (i == requests_.End() || i->second_.state_ == REQUEST_CANCELLED) {
+        return false;
+    }
+
+    if (i->second_.state_ == REQUEST_INFLIGHT) {
+        i->second_.state_ = REQUEST_CANCELLED;
+    } else {
+        --numQueued_[i->second_.priority_];
+        requests_.Erase(i);
+    }
+    return true;
+}
+
+void PrefetchScheduler::CancelPriority(PrefetchPriority priority)
+{
+    for (HashMap<StringHash, PrefetchRequest>::Iterator i = requests_.Begin(); i != requests_.End();) {
+        if (i->second_.state_ == REQUEST_QUEUED && i->second_.priority_ == priority) {
+            i = requests_.Erase(i);
+        } else {
+            ++i;
+        }
+    }
+
+    PriorityQueue& queue = queues_[priority];
+    queue.entries_.Clear();
+    queue.head_ = 0;
+    numQueued_[priority] = 0;
+}
+
+void PrefetchScheduler::SetFinishBudgetMs(int ms)
+{
+    GetSubsystem<ResourceCache>()->SetFinishBackgroundResourcesMs(ms);
+}
+
+int PrefetchScheduler::GetFinishBudgetMs() const
+{
+    return GetSubsystem<ResourceCache>()->GetFinishBackgroundResourcesMs();
+}
+
+bool PrefetchScheduler::IsIdle() const
+{
+    return requests_.Empty();
+}
+
+void PrefetchScheduler::Enqueue(StringHash key, PrefetchPriority priority, unsigned sequence)
+{
+    PriorityQueue& queue = queues_[priority];
+
+    // Drop the already consumed front once it is the larger part of the queue
+    if (queue.head_ > 64 && queue.head_ * 2 > queue.entries_.Size()) {
+        queue.entries_.Erase(0, queue.head_);
+        queue.head_ = 0;
+    }
+
+    QueueEntry entry;
+    entry.key_ = key;
+    entry.sequence_ = sequence;
+    queue.entries_.Push(entry);
+}
+
+void PrefetchScheduler::Submit(StringHash key)
+{
+    PrefetchRequest& request = requests_[key];
+    --numQueued_[request.priority_];
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    ResourceTelemetry* telemetry = GetSubsystem<ResourceTelemetry>();
+    ResourceScopes* scopes = GetSubsystem<ResourceScopes>();
+    if (scopes) {
+        scopes->Track(request.type_, request.name_);
+    }
+    long long start = telemetry ? telemetry->GetTime() : 0;
+    bool queued = cache->BackgroundLoadResource(request.type_, request.name_);
+    if (queued && telemetry) {
+        telemetry->RecordQueued(request.type_, request.name_, start);
+    }
+
+    // Unlike SendBackgroundLoadResource this never falls back on GetResource,
+    // a resource that is not already loaded is never loaded synchronously,
+    // but without threading a queued one was loaded right away with no event
+    Resource* resource = cache->GetExistingResource(request.type_, request.name_);
+    if (queued && !resource) {
+        request.state_ = REQUEST_INFLIGHT;
+        ++inFlight_;
+        return;
+    }
+    if (resource) {
+        using namespace ResourceBackgroundLoaded;
+
+        if (telemetry && !queued) {
+            telemetry->RecordCacheHit(request.type_);
+        }
+        String name = request.name_;
+        requests_.Erase(key);
+
+        VariantMap& eventData = context_->GetEventDataMap();
+        eventData[P_RESOURCENAME] = name;
+        eventData[P_SUCCESS] = true;
+        eventData[P_RESOURCE] = resource;
+        cache->SendEvent(E_RESOURCEBACKGROUNDLOADED, eventData);
+    } else if (!cache->Exists(request.name_) || !cache->GetNumBackgroundLoadResources()) {
+        // Missing, or nothing is being background loaded so no event of it
+        // is coming, such as a synchronous load without threading that failed
+        using namespace LoadFailed;
+
+        if (telemetry) {
+            telemetry->RecordFailure(request.type_);
+        }
+        String name = request.name_;
+        requests_.Erase(key);
+
+        VariantMap& eventData = context_->GetEventDataMap();
+        eventData[P_RESOURCENAME] = name;
+        cache->SendEvent(E_LOADFAILED, eventData);
+    } else {
+        // Already queued by someone else, its event will still arrive
+        request.state_ = REQUEST_INFLIGHT;
+        ++inFlight_;
+    }
+}
+
+void PrefetchScheduler::HandleUpdate(StringHash eventType, VariantMap& eventData)
+{
+    for (unsigned p = 0; p < MAX_PREFETCH_PRIORITIES; ++p) {
+        PriorityQueue& queue = queues_[p];
+        while (queue.head_ < queue.entries_.Size()) {
+            if (p != PREFETCH_CRITICAL && inFlight_ >= maxInFlight_) {
+                return;
+            }
+
+            QueueEntry entry = queue.entries_[queue.head_++];
+            HashMap<StringHash, PrefetchRequest>::ConstIterator i = requests_.Find(entry.key_);
+            if (i == requests_.End() || i->second_.state_ != REQUEST_QUEUED || i->second_.sequence_ != entry.sequence_) {
+                continue; // Cancelled or re-prioritized since
+            }
+            Submit(entry.key_);
+        }
+
+        queue.entries_.Clear();
+        queue.head_ = 0;
+    }
+}
+
+void PrefetchScheduler::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    Resource* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+    if (!resource) {
+        return;
+    }
+
+    HashMap<StringHash, PrefetchRequest>::Iterator i = requests_.Find(MakeKey(resource->GetType(), eventData[P_RESOURCENAME].GetString()));
+    if (i == requests_.End() || i->second_.state_ == REQUEST_QUEUED) {
+        return;
+    }
+
+    --inFlight_;
+    requests_.Erase(i);
+}
@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/ResourceScopes.hpp"
+#include "Urho3D-OverLib/StateManager.hpp"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Resource/ResourceCache.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+ResourceScopes::ResourceScopes(Context* context)
+    : Object(context)
+{
+}
+
+ResourceScopes::~ResourceScopes()
+{
+}
+
+void ResourceScopes::Track(StringHash type, const String& name)
+{
+    Object* state = GetActiveScope();
+    if (state) {
+        Track(state, type, name);
+    }
+}
+
+void ResourceScopes::Track(Object* state, StringHash type, const String& name)
+{
+    if (!state || name.Empty()) {
+        return;
+    }
+
+    String sanitatedName = GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+    StringHash key = GetResourceKey(type, sanitatedName);
+    HashSet<StringHash>& scope = scopes_[state];
+    if (scope.Contains(key)) {
+        return;
+    }
+    scope.Insert(key);
+
+    HashMap<StringHash, ScopedResource>::Iterator i = resources_.Find(key);
+    if (i != resources_.End()) {
+        // Taken again before its release, such as by the incoming state
+        ++i->second_.references_;
+        return;
+    }
+    ScopedResource& resource = resources_[key];
+    resource.type_ = type;
+    resource.name_ = sanitatedName;
+    resource.references_ = 1;
+}
+
+Object* ResourceScopes::GetActiveScope() const
+{
+    StateManager* stateManager = GetSubsystem<StateManager>();
+    if (!stateManager) {
+        return 0;
+    }
+
+    Object* state = stateManager->GetState();
+    if (state && !stateManager->IsStateReady(state)) {
+        return state;
+    }
+    Object* preloadState = stateManager->GetPreloadState();
+    if (preloadState && !stateManager->IsStateReady(preloadState)) {
+        return preloadState;
+    }
+    return stateManager->GetTopState();
+}
+
+void ResourceScopes::ReleaseScope(Object* state)
+{
+    HashMap<Object*, HashSet<StringHash> >::Iterator i = scopes_.Find(state);
+    if (i == scopes_.End()) {
+        return;
+    }
+
+    for (HashSet<StringHash>::ConstIterator j = i->second_.Begin(); j != i->second_.End(); ++j) {
+        ScopedResource& resource = resources_[*j];
+        if (--resource.references_ == 0) {
+            pendingRelease_.Push(*j);
+        }
+    }
+    scopes_.Erase(i);
+
+    // While a state is loading behind the loading screen it has not asked for
+    // what it shares with the ending state yet, so wait for it to finish
+    StateManager* stateManager = GetSubsystem<StateManager>();
+    Object* current = stateManager ? stateManager->GetState() : 0;
+    if (!current || stateManager->IsStateReady(current)) {
+        ReleasePending();
+    }
+}
+
+void ResourceScopes::ReleasePending()
+{
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    for (unsigned i = 0; i < pendingRelease_.Size(); ++i) {
+        HashMap<StringHash, ScopedResource>::Iterator j = resources_.Find(pendingRelease_[i]);
+        if (j == resources_.End() || j->second_.references_ > 0) {
+            continue; // Released already or taken again
+        }
+        // Not forced, anything still using the resource keeps it loaded
+        cache->ReleaseResource(j->second_.type_, j->second_.name_, false);
+        resources_.Erase(j);
+    }
+    pendingRelease_.Clear();
+}
+
+unsigned ResourceScopes::GetNumScoped(Object* state) const
+{
+    HashMap<Object*, HashSet<StringHash> >::ConstIterator i = scopes_.Find(state);
+    return i != scopes_.End() ? i->second_.Size() : 0;
+}
+
+unsigned ResourceScopes::GetNumReferences(StringHash type, const String& name) const
+{
+    String sanitatedName = GetSubsystem<ResourceCache>()->SanitateResourceName(name);
+    HashMap<StringHash, ScopedResource>::ConstIterator i = resources_.Find(GetResourceKey(type, sanitatedName));
+    return i != resources_.End() ? i->second_.references_ : 0;
+}
+
+StringHash ResourceScopes::GetResourceKey(StringHash type, const String& sanitatedName) const
+{
+    // The same name may well be loaded as more than one type
+    return StringHash(StringHash(sanitatedName).Value() ^ (type.Value() * 31));
+}
@@ -0,0 +1,209 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/ResourceTelemetry.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/Resource/Resource.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/ResourceEvents.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+ResourceTelemetry::ResourceTelemetry(Context* context)
+    : Object(context)
+{
+    SubscribeToEvent(GetSubsystem<ResourceCache>(), E_RESOURCEBACKGROUNDLOADED, HANDLER(ResourceTelemetry, HandleResourceBackgroundLoaded));
+}
+
+ResourceTelemetry::~ResourceTelemetry()
+{
+}
+
+const ResourceTypeTelemetry* ResourceTelemetry::GetTypeTelemetry(StringHash type) const
+{
+    HashMap<StringHash, ResourceTypeTelemetry>::ConstIterator i = types_.Find(type);
+    return i != types_.End() ? &i->second_ : 0;
+}
+
+void ResourceTelemetry::Reset()
+{
+    types_.Clear();
+}
+
+String ResourceTelemetry::GetReport() const
+{
+    String report = "{\n    \"resourceTypes\": [";
+    for (HashMap<StringHash, ResourceTypeTelemetry>::ConstIterator i = types_.Begin(); i != types_.End(); ++i) {
+        const ResourceTypeTelemetry& telemetry = i->second_;
+        unsigned numLoads = telemetry.loaded_ + telemetry.syncLoads_;
+
+        char buffer[256];
+        sprintf(buffer, "\",\n            \"cacheHits\": %u, \"queued\": %u, \"loaded\": %u, \"syncLoads\": %u, \"failures\": %u,\n"
+            "            \"bytes\": %llu, \"averageLatencyUs\": %lld, \"maxLatencyUs\": %lld,\n            \"latencyHistogramUs\": [",
+            telemetry.cacheHits_, telemetry.queued_, telemetry.loaded_, telemetry.syncLoads_, telemetry.failures_,
+            telemetry.bytes_, numLoads ? telemetry.totalLatency_ / numLoads : 0LL, telemetry.maxLatency_);
+
+        report += i == types_.Begin() ? "\n" : ",\n";
+        report += "        {\n            \"type\": \"" + telemetry.typeName_ + buffer;
+        for (unsigned j = 0; j < NUM_LATENCY_BUCKETS; ++j) {
+            report += (j ? ", " : "") + String(telemetry.latencyHistogram_[j]);
+        }
+        report += "]\n        }";
+    }
+    report += "\n    ]\n}\n";
+    return report;
+}
+
+bool ResourceTelemetry::SaveReport(const String& fileName) const
+{
+    File file(context_, fileName, FILE_WRITE);
+    if (!file.IsOpen()) {
+        return false;
+    }
+    String report = GetReport();
+    return file.Write(report.CString(), report.Length()) == report.Length();
+}
+
+void ResourceTelemetry::RecordQueued(StringHash type, const String& name, long long start)
+{
+    // Without threading it was loaded right away and no event will come
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    Resource* resource = cache->GetExistingResource(type, name);
+    if (resource) {
+        RecordSyncLoad(type, resource, start);
+        return;
+    }
+
+    ++GetOrCreateTypeTelemetry(type).queued_;
+
+    // A second request for a load already in flight is timed from the first
+    StringHash key = GetPendingKey(type, cache->SanitateResourceName(name));
+    if (!pending_.Contains(key)) {
+        PendingLoad& load = pending_[key];
+        load.type_ = type;
+        load.start_ = start;
+    }
+}
+
+bool ResourceTelemetry::IsPending(StringHash type, const String& name) const
+{
+    return pending_.Contains(GetPendingKey(type, GetSubsystem<ResourceCache>()->SanitateResourceName(name)));
+}
+
+void ResourceTelemetry::RecordCacheHit(StringHash type)
+{
+    ++GetOrCreateTypeTelemetry(type).cacheHits_;
+}
+
+void ResourceTelemetry::RecordFailure(StringHash type)
+{
+    ++GetOrCreateTypeTelemetry(type).failures_;
+}
+
+void ResourceTelemetry::RecordSyncLoad(StringHash type, Resource* resource, long long start)
+{
+    ResourceTypeTelemetry& telemetry = GetOrCreateTypeTelemetry(type);
+    if (!resource) {
+        ++telemetry.failures_;
+        return;
+    }
+    ++telemetry.syncLoads_;
+    telemetry.bytes_ += resource->GetMemoryUse();
+    RecordLatency(telemetry, GetTime() - start);
+}
+
+StringHash ResourceTelemetry::GetPendingKey(StringHash type, const String& sanitatedName) const
+{
+    return StringHash(StringHash(sanitatedName).Value() ^ (type.Value() * 31));
+}
+
+ResourceTypeTelemetry& ResourceTelemetry::GetOrCreateTypeTelemetry(StringHash type)
+{
+    HashMap<StringHash, ResourceTypeTelemetry>::Iterator i = types_.Find(type);
+    if (i != types_.End()) {
+        return i->second_;
+    }
+
+    ResourceTypeTelemetry& telemetry = types_[type];
+    telemetry.type_ = type;
+    telemetry.typeName_ = context_->GetTypeName(type);
+    if (telemetry.typeName_.Empty()) {
+        telemetry.typeName_ = type.ToString();
+    }
+    telemetry.cacheHits_ = 0;
+    telemetry.queued_ = 0;
+    telemetry.loaded_ = 0;
+    telemetry.syncLoads_ = 0;
+    telemetry.failures_ = 0;
+    telemetry.bytes_ = 0;
+    telemetry.totalLatency_ = 0;
+    telemetry.maxLatency_ = 0;
+    memset(telemetry.latencyHistogram_, 0, sizeof(telemetry.latencyHistogram_));
+    return telemetry;
+}
+
+void ResourceTelemetry::RecordLatency(ResourceTypeTelemetry& telemetry, long long latency)
+{
+    unsigned bucket = 0;
+    for (long long l = latency; l > 1 && bucket < NUM_LATENCY_BUCKETS - 1; l >>= 1) {
+        ++bucket;
+    }
+    ++telemetry.latencyHistogram_[bucket];
+    telemetry.totalLatency_ += latency;
+    if (latency > telemetry.maxLatency_) {
+        telemetry.maxLatency_ = latency;
+    }
+}
+
+void ResourceTelemetry::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ResourceBackgroundLoaded;
+
+    // Sent with the resource even when it failed, which gives the type
+    Resource* resource = static_cast<Resource*>(eventData[P_RESOURCE].GetPtr());
+    if (!resource) {
+        return;
+    }
+    HashMap<StringHash, PendingLoad>::Iterator i = pending_.Find(GetPendingKey(resource->GetType(), eventData[P_RESOURCENAME].GetString()));
+    if (i == pending_.End()) {
+        return; // Not queued through us, or a cache hit sending its event
+    }
+    PendingLoad load = i->second_;
+    pending_.Erase(i);
+
+    ResourceTypeTelemetry& telemetry = GetOrCreateTypeTelemetry(load.type_);
+    if (!eventData[P_SUCCESS].GetBool()) {
+        ++telemetry.failures_;
+        return;
+    }
+    ++telemetry.loaded_;
+    telemetry.bytes_ += resource->GetMemoryUse();
+    RecordLatency(telemetry, GetTime() - load.start_);
+}
@@ -21,20 +21,89 @@
 //
 
 #include "Urho3D-OverLib/StateManager.hpp"
+#include "Urho3D-OverLib/BatchLoader.hpp"
+#include "Urho3D-OverLib/InputMapper.hpp"
+#include "Urho3D-OverLib/OverLib.hpp"
+#include "Urho3D-OverLib/ResourceScopes.hpp"
+#include "Urho3D-OverLib/StateTransitionProfiler.hpp"
 
 #include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
 
 using namespace Urho3D;
 using namespace OverLib;
 
 
+static void ProcessBackgroundTask(const WorkItem* item, unsigned threadIndex)
+{
+    static_cast<BackgroundTask*>(item->aux_)->Process();
+}
+
 StateObject::StateObject(Context* context): Object(context)
 {
-    SubscribeToEvent(this, E_STATEPRESTART, HANDLER(StateObject, HandleStatePreStart));
-    SubscribeToEvent(this, E_STATESTART, HANDLER(StateObject, HandleStateStart));
-    SubscribeToEvent(this, E_STATEEND, HANDLER(StateObject, HandleStateEnd));
-    SubscribeToEvent(this, E_STATEPOSTEND, HANDLER(StateObject, HandleStatePostEnd));
-    SubscribeToEvent(this, E_STATELOADINGUPDATE, HANDLER(StateObject, HandleLoadingUpdate));
+}
+
+void StateObject::OnStatePreStart()
+{
+    HandleStatePreStart(E_STATEPRESTART, context_->GetEventDataMap());
+}
+
+void StateObject::OnStateStart()
+{
+    HandleStateStart(E_STATESTART, context_->GetEventDataMap());
+}
+
+void StateObject::OnStateEnd()
+{
+    HandleStateEnd(E_STATEEND, context_->GetEventDataMap());
+}
+
+void StateObject::OnStatePostEnd()
+{
+    HandleStatePostEnd(E_STATEPOSTEND, context_->GetEventDataMap());
+}
+
+void StateObject::OnStateSuspend(bool keepUpdating, bool keepRendering)
+{
+    // Not the context's event data, nothing was sent to keep a handler from
+    // clearing it under us by sending an event of its own.  Cleared nodes are
+    // kept for reuse so after the first call this allocates nothing
+    using namespace StateSuspend;
+    eventData_.Clear();
+    eventData_[P_KEEPUPDATING] = keepUpdating;
+    eventData_[P_KEEPRENDERING] = keepRendering;
+    HandleStateSuspend(E_STATESUSPEND, eventData_);
+}
+
+void StateObject::OnStateResume()
+{
+    HandleStateResume(E_STATERESUME, context_->GetEventDataMap());
+}
+
+void StateObject::OnLoadingUpdate(const String& message)
+{
+    using namespace StateLoadingUpdate;
+    eventData_.Clear();
+    eventData_[P_MESSAGE] = message;
+    HandleLoadingUpdate(E_STATELOADINGUPDATE, eventData_);
+}
+
+void StateObject::OnLoadingProgress(unsigned taskIndex, unsigned numTasks, float taskProgress, float progress, const String& label)
+{
+    using namespace StateLoadingProgress;
+    eventData_.Clear();
+    eventData_[P_TASKINDEX] = taskIndex;
+    eventData_[P_NUMTASKS] = numTasks;
+    eventData_[P_TASKPROGRESS] = taskProgress;
+    eventData_[P_PROGRESS] = progress;
+    eventData_[P_LABEL] = label;
+    HandleLoadingProgress(E_STATELOADINGPROGRESS, eventData_);
 }
 
 void StateObject::HandleStatePreStart(StringHash eventType, VariantMap& eventData)
@@ -57,28 +126,73 @@ void StateObject::HandleLoadingUpdate(StringHash eventType, VariantMap& eventDat
 {
 }
 
+void StateObject::HandleStateSuspend(StringHash eventType, VariantMap& eventData)
+{
+}
+
+void StateObject::HandleStateResume(StringHash eventType, VariantMap& eventData)
+{
+}
+
+void StateObject::HandleLoadingProgress(StringHash eventType, VariantMap& eventData)
+{
+}
+
 void StateObject::PostLoadingUpdate(const String& msg)
 {
-    GetSubsystem<OverLib::StateManager>()->PostLoadingUpdate(msg);
+    GetSubsystem<OverLib::StateManager>()->PostLoadingUpdate(this, msg);
 }
 
 void StateObject::PostLoadingComplete()
 {
-    GetSubsystem<OverLib::StateManager>()->PostLoadingComplete();
+    GetSubsystem<OverLib::StateManager>()->PostLoadingComplete(this);
+}
+
+void StateObject::AddLoadingTask(LoadingTask* task)
+{
+    GetSubsystem<OverLib::StateManager>()->AddLoadingTask(this, task);
+}
+
+void StateObject::AddBackgroundTask(BackgroundTask* task)
+{
+    GetSubsystem<OverLib::StateManager>()->AddBackgroundTask(this, task);
+}
+
+void StateObject::SetInputContext(InputContext* context)
+{
+    Urho3D::OverLib::OverLib::GetOrCreateSubSystem<InputMapper>(context_)->SetStateContext(this, context);
 }
 
 
 StateManager::StateManager(Context* context)
     : Object(context)
+    , loadingTasksDone_(0)
+    , loadingTaskBudget_(8.0f)
+    , preloadReady_(false)
+    , settingState_(false)
+    , completePending_(false)
+    , autoComplete_(false)
+    , preloadAutoComplete_(false)
     , internalState_(NO_TRANSITION)
 {
+    baseSuspend_.suspended_ = false;
+    baseSuspend_.flags_ = OVERLAY_RUN_BELOW;
 }
 
 StateManager::StateManager(Context* context, Object* loadingState)
     : Object(context)
     , loadingState_(loadingState)
+    , loadingTasksDone_(0)
+    , loadingTaskBudget_(8.0f)
+    , preloadReady_(false)
+    , settingState_(false)
+    , completePending_(false)
+    , autoComplete_(false)
+    , preloadAutoComplete_(false)
     , internalState_(NO_TRANSITION)
 {
+    baseSuspend_.suspended_ = false;
+    baseSuspend_.flags_ = OVERLAY_RUN_BELOW;
     SetState(loadingState_);
 }
 
@@ -91,36 +205,269 @@ Object* StateManager::GetState()
     return state_;
 }
 
+void StateManager::SetProfiling(bool enable)
+{
+    if (enable && !profiler_) {
+        profiler_ = new StateTransitionProfiler(context_);
+    }
+    else if (!enable) {
+        profiler_.Reset();
+    }
+}
+
+struct StateManager::StateEventArgs {
+    StateEventArgs()
+        : oldState_(0)
+        , newState_(0)
+        , message_(&String::EMPTY)
+        , label_(&String::EMPTY)
+        , keepUpdating_(false)
+        , keepRendering_(false)
+        , taskIndex_(0)
+        , numTasks_(0)
+        , taskProgress_(0.0f)
+        , progress_(0.0f)
+    {
+    }
+
+    Object* oldState_;
+    /// Also the state of E_STATEPRELOADED
+    Object* newState_;
+    const String* message_;
+    const String* label_;
+    bool keepUpdating_;
+    bool keepRendering_;
+    unsigned taskIndex_;
+    unsigned numTasks_;
+    float taskProgress_;
+    float progress_;
+};
+
+void StateManager::SendStateEvent(Object* sender, StringHash eventType)
+{
+    SendStateEvent(sender, eventType, StateEventArgs());
+}
+
+void StateManager::SendStateEvent(Object* sender, StringHash eventType, const StateEventArgs& args)
+{
+    // Held, a handler may well turn profiling off
+    SharedPtr<StateTransitionProfiler> profiler(profiler_);
+    long long start = profiler ? profiler->GetTime() : 0;
+
+    StateLifecycle* lifecycle = sender != this ? dynamic_cast<StateLifecycle*>(sender) : 0;
+    if (lifecycle) {
+        CallStateLifecycle(lifecycle, eventType, args);
+    }
+    NotifySubsystems(sender, eventType);
+
+    if (HasStateEventReceivers(sender, eventType)) {
+        VariantMap& eventData = context_->GetEventDataMap();
+        if (eventType == E_STATELOADINGSTART) {
+            using namespace StateLoadingStart;
+            eventData[P_OLDSTATE] = args.oldState_;
+            eventData[P_NEWSTATE] = args.newState_;
+        }
+        else if (eventType == E_STATELOADINGEND) {
+            using namespace StateLoadingEnd;
+            eventData[P_NEWSTATE] = args.newState_;
+        }
+        else if (eventType == E_STATEPRELOADED) {
+            using namespace StatePreloaded;
+            eventData[P_STATE] = args.newState_;
+        }
+        else if (eventType == E_STATESUSPEND) {
+            using namespace StateSuspend;
+            eventData[P_KEEPUPDATING] = args.keepUpdating_;
+            eventData[P_KEEPRENDERING] = args.keepRendering_;
+        }
+        else if (eventType == E_STATELOADINGUPDATE) {
+            using namespace StateLoadingUpdate;
+            eventData[P_MESSAGE] = *args.message_;
+        }
+        else if (eventType == E_STATELOADINGPROGRESS) {
+            using namespace StateLoadingProgress;
+            eventData[P_TASKINDEX] = args.taskIndex_;
+            eventData[P_NUMTASKS] = args.numTasks_;
+            eventData[P_TASKPROGRESS] = args.taskProgress_;
+            eventData[P_PROGRESS] = args.progress_;
+            eventData[P_LABEL] = *args.label_;
+        }
+        sender->SendEvent(eventType, eventData);
+    }
+
+    if (profiler) {
+        profiler->RecordEvent(sender, eventType, start);
+    }
+}
+
+void StateManager::CallStateLifecycle(StateLifecycle* lifecycle, StringHash eventType, const StateEventArgs& args)
+{
+    if (eventType == E_STATEPRESTART) {
+        lifecycle->OnStatePreStart();
+    }
+    else if (eventType == E_STATESTART) {
+        lifecycle->OnStateStart();
+    }
+    else if (eventType == E_STATEEND) {
+        lifecycle->OnStateEnd();
+    }
+    else if (eventType == E_STATEPOSTEND) {
+        lifecycle->OnStatePostEnd();
+    }
+    else if (eventType == E_STATESUSPEND) {
+        lifecycle->OnStateSuspend(args.keepUpdating_, args.keepRendering_);
+    }
+    else if (eventType == E_STATERESUME) {
+        lifecycle->OnStateResume();
+    }
+    else if (eventType == E_STATELOADINGUPDATE) {
+        lifecycle->OnLoadingUpdate(*args.message_);
+    }
+    else if (eventType == E_STATELOADINGPROGRESS) {
+        lifecycle->OnLoadingProgress(args.taskIndex_, args.numTasks_, args.taskProgress_, args.progress_, *args.label_);
+    }
+}
+
+void StateManager::NotifySubsystems(Object* sender, StringHash eventType)
+{
+    // Called directly, were they subscribed to every state's events the
+    // events would always have a receiver and always be sent
+    if (eventType == E_STATESTART || eventType == E_STATEEND) {
+        InputMapper* inputMapper = GetSubsystem<InputMapper>();
+        if (inputMapper && eventType == E_STATESTART) {
+            inputMapper->StartStateContext(sender);
+        }
+        else if (inputMapper) {
+            inputMapper->EndStateContext(sender);
+        }
+    }
+    else if (eventType == E_STATEPOSTEND || eventType == E_STATELOADINGEND) {
+        ResourceScopes* scopes = GetSubsystem<ResourceScopes>();
+        if (scopes && eventType == E_STATEPOSTEND) {
+            scopes->ReleaseScope(sender);
+        }
+        else if (scopes) {
+            scopes->ReleasePending();
+        }
+    }
+}
+
+bool StateManager::HasStateEventReceivers(Object* sender, StringHash eventType) const
+{
+    // A group once subscribed to stays after its last receiver is gone, so
+    // this errs on the side of sending
+    return context_->GetEventReceivers(sender, eventType) || context_->GetEventReceivers(eventType);
+}
+
 void StateManager::SetState(Object* state)
 {
     if (internalState_ != NO_TRANSITION) {
         throw "Tried to set state while already setting a state";
     }
+
+    bool preloaded = state && state == preloadState_;
+    if (preloaded && preloadReady_) {
+        SwitchToPreloadedState();
+        return;
+    }
+    if (profiler_) {
+        profiler_->BeginTransition("SetState", state_, state);
+    }
+    if (!preloaded) {
+        CancelPreload();
+    }
+    ClearOverlays();
+
     internalState_ = LOADINGSCREEN;
+    settingState_ = true;
+
+    // Held so the old state lives until the loading start event is out
+    SharedPtr<Object> oldState(state_);
+    state_ = state;
+    preloadState_.Reset();
+    RemoveLoadingTasks(oldState);
+    loadingTasksDone_ = 0;
+    autoComplete_ = preloaded && preloadAutoComplete_;
+    preloadAutoComplete_ = false;
+
+    // Claimed before the old state ends so nothing shared is released
+    releaseManifest_ = manifestLoader_;
+    manifestLoader_ = preloaded ? preloadManifestLoader_ : StartManifest(state);
+    preloadManifestLoader_.Reset();
 
     if (loadingState_) {
-        loadingState_->SendEvent(E_STATEPRESTART);
+        SendStateEvent(loadingState_, E_STATEPRESTART);
     }
-    if (state_) {
-        state_->SendEvent(E_STATEEND);
+    if (oldState) {
+        SendStateEvent(oldState, E_STATEEND);
     }
     if (loadingState_) {
-        loadingState_->SendEvent(E_STATESTART);
+        SendStateEvent(loadingState_, E_STATESTART);
     }
-    if (state_) {
-        state_->SendEvent(E_STATEPOSTEND);
+    if (oldState) {
+        SendStateEvent(oldState, E_STATEPOSTEND);
     }
-    if (state) {
-        state->SendEvent(E_STATEPRESTART);
+    if (state && !preloaded) {
+        SendStateEvent(state, E_STATEPRESTART);
     }
 
-    using namespace StateLoadingStart;
-    VariantMap& eventData = context_->GetEventDataMap();
-    eventData[P_OLDSTATE] = state_;
-    eventData[P_NEWSTATE] = state;
-    SendEvent(E_STATELOADINGSTART, eventData);
+    StateEventArgs args;
+    args.oldState_ = oldState;
+    args.newState_ = state;
+    SendStateEvent(this, E_STATELOADINGSTART, args);
 
-    state_ = state;
+    if (profiler_) {
+        profiler_->BeginLoading();
+    }
+    settingState_ = false;
+    if (completePending_) {
+        completePending_ = false;
+        // Tasks it added after completing synchronously complete it instead
+        if (!HasLoadingTasks(state_)) {
+            PostLoadingComplete();
+        }
+    }
+}
+
+void StateManager::SwitchToPreloadedState()
+{
+    if (profiler_) {
+        profiler_->BeginTransition("SetStatePreloaded", state_, preloadState_);
+    }
+    ClearOverlays();
+
+    SharedPtr<Object> oldState(state_);
+    state_ = preloadState_;
+    preloadState_.Reset();
+    preloadReady_ = false;
+    autoComplete_ = false;
+    preloadAutoComplete_ = false;
+    RemoveLoadingTasks(oldState);
+    releaseManifest_ = manifestLoader_;
+    manifestLoader_ = preloadManifestLoader_;
+    preloadManifestLoader_.Reset();
+
+    StateEventArgs args;
+    args.oldState_ = oldState;
+    args.newState_ = state_;
+    SendStateEvent(this, E_STATELOADINGSTART, args);
+
+    if (oldState) {
+        SendStateEvent(oldState, E_STATEEND);
+    }
+    SendStateEvent(state_, E_STATESTART);
+    if (oldState) {
+        SendStateEvent(oldState, E_STATEPOSTEND);
+    }
+    ReleaseUnusedManifest();
+
+    args.oldState_ = 0;
+    args.newState_ = state_;
+    SendStateEvent(this, E_STATELOADINGEND, args);
+
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
 }
 
 void StateManager::PostLoadingComplete()
@@ -128,22 +475,220 @@ void StateManager::PostLoadingComplete()
     if (internalState_ != LOADINGSCREEN) {
         throw "Tried to post done loading to switch to final state while not loading";
     }
+    if (HasLoadingTasks(state_)) {
+        // Such as its manifest, the last of them to finish completes it
+        autoComplete_ = true;
+        return;
+    }
+    if (settingState_) {
+        // Loaded synchronously in its PreStart, finish once SetState is done
+        completePending_ = true;
+        return;
+    }
     internalState_ = NO_TRANSITION;
+    if (profiler_) {
+        profiler_->EndLoading();
+    }
 
     if (loadingState_) {
-        loadingState_->SendEvent(E_STATEEND);
+        SendStateEvent(loadingState_, E_STATEEND);
     }
     if (state_) {
-        state_->SendEvent(E_STATESTART);
+        SendStateEvent(state_, E_STATESTART);
     }
     if (loadingState_) {
-        loadingState_->SendEvent(E_STATEPOSTEND);
+        SendStateEvent(loadingState_, E_STATEPOSTEND);
     }
+    ReleaseUnusedManifest();
 
-    using namespace StateLoadingEnd;
-    VariantMap& eventData = context_->GetEventDataMap();
-    eventData[P_NEWSTATE] = state_;
-    SendEvent(E_STATELOADINGEND, eventData);
+    StateEventArgs args;
+    args.newState_ = state_;
+    SendStateEvent(this, E_STATELOADINGEND, args);
+
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+void StateManager::PostLoadingComplete(Object* state)
+{
+    if (FindOverlay(state) != M_MAX_UNSIGNED) {
+        return; // Overlays are started as soon as they are pushed
+    }
+    if (state && state == preloadState_) {
+        if (HasLoadingTasks(state)) {
+            preloadAutoComplete_ = true;
+        }
+        else if (!preloadReady_) {
+            preloadReady_ = true;
+
+            StateEventArgs args;
+            args.newState_ = state;
+            SendStateEvent(this, E_STATEPRELOADED, args);
+        }
+        return;
+    }
+    if (state != state_) {
+        return; // A cancelled preload or an old state still finishing its loading
+    }
+    PostLoadingComplete();
+}
+
+void StateManager::PreloadState(Object* state)
+{
+    if (state == preloadState_) {
+        return;
+    }
+    if (state && state == state_) {
+        throw "Tried to preload the current state";
+    }
+    CancelPreload();
+    if (!state) {
+        return;
+    }
+
+    preloadState_ = state;
+    preloadReady_ = false;
+    preloadAutoComplete_ = false;
+    preloadManifestLoader_ = StartManifest(state);
+    if (profiler_) {
+        profiler_->BeginTransition("PreloadState", state_, state);
+    }
+    SendStateEvent(state, E_STATEPRESTART);
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+void StateManager::CancelPreload()
+{
+    if (!preloadState_) {
+        return;
+    }
+
+    SharedPtr<Object> state(preloadState_);
+    preloadState_.Reset();
+    preloadReady_ = false;
+    preloadAutoComplete_ = false;
+    preloadManifestLoader_.Reset();
+    RemoveLoadingTasks(state);
+    if (profiler_) {
+        profiler_->BeginTransition("CancelPreload", state, 0);
+    }
+    SendStateEvent(state, E_STATEPOSTEND);
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+Object* StateManager::GetPreloadState()
+{
+    return preloadState_;
+}
+
+void StateManager::SetStateManifest(Object* state, XMLFile* manifest)
+{
+    if (!state) {
+        return;
+    }
+    for (unsigned i = 0; i < manifests_.Size(); ++i) {
+        if (manifests_[i].state_ == state) {
+            if (manifest) {
+                manifests_[i].manifest_ = manifest;
+            } else {
+                manifests_.Erase(i);
+            }
+            return;
+        }
+    }
+    if (manifest) {
+        StateManifest entry;
+        entry.state_ = state;
+        entry.manifest_ = manifest;
+        manifests_.Push(entry);
+    }
+}
+
+XMLFile* StateManager::GetStateManifest(Object* state) const
+{
+    for (unsigned i = 0; i < manifests_.Size(); ++i) {
+        if (manifests_[i].state_ == state) {
+            return manifests_[i].manifest_;
+        }
+    }
+    return 0;
+}
+
+SharedPtr<BatchLoader> StateManager::StartManifest(Object* state)
+{
+    XMLFile* manifest = GetStateManifest(state);
+    if (!manifest) {
+        return SharedPtr<BatchLoader>();
+    }
+
+    SharedPtr<BatchLoader> loader(new BatchLoader(context_));
+    loader->AddManifest(manifest);
+    // Until the state has started, so what it shares with the old state is
+    // not unloaded by the old state releasing its own in its PostEnd
+    loader->SetHoldResources(true);
+
+    // With scopes the state holds its resources from now on, which keeps them
+    // from being released when the old state ends
+    ResourceScopes* scopes = GetSubsystem<ResourceScopes>();
+    if (scopes) {
+        for (unsigned i = 0; i < loader->GetNumTotal(); ++i) {
+            scopes->Track(state, loader->GetResourceType(i), loader->GetResourceName(i));
+        }
+    }
+
+    // Already loaded resources are done at once, only the rest is queued
+    loader->Start();
+    if (!loader->IsComplete()) {
+        // It only holds back the state's completion, a state doing loading
+        // of its own still completes itself
+        SharedPtr<LoadingTask> task(new BatchLoadingTask(loader, "Loading resources"));
+        task->gateOnly_ = true;
+        AddLoadingTask(state, task);
+    }
+    return loader;
+}
+
+void StateManager::ReleaseUnusedManifest()
+{
+    SharedPtr<BatchLoader> outgoing(releaseManifest_);
+    releaseManifest_.Reset();
+    // The state has started, from now on its resources are its own to release
+    if (manifestLoader_) {
+        manifestLoader_->SetHoldResources(false);
+    }
+    if (!outgoing) {
+        return;
+    }
+    outgoing->SetHoldResources(false);
+    // ResourceScopes does this itself and knows of more than the manifests
+    if (GetSubsystem<ResourceScopes>()) {
+        return;
+    }
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    for (unsigned i = 0; i < outgoing->GetNumTotal(); ++i) {
+        StringHash type = outgoing->GetResourceType(i);
+        const String& name = outgoing->GetResourceName(i);
+        if (!manifestLoader_ || !manifestLoader_->HasResource(type, name)) {
+            cache->ReleaseResource(type, name, false);
+        }
+    }
+}
+
+bool StateManager::IsStateReady(Object* state) const
+{
+    if (!state) {
+        return false;
+    }
+    if (state == preloadState_) {
+        return preloadReady_;
+    }
+    return state == state_ && internalState_ == NO_TRANSITION;
 }
 
 void StateManager::SetLoadingState(Object* loadingState)
@@ -159,12 +704,507 @@ Object* StateManager::GetLoadingState()
     return loadingState_;
 }
 
+void StateManager::PushState(Object* state, unsigned overlayFlags)
+{
+    if (internalState_ != NO_TRANSITION) {
+        throw "Tried to push a state while setting a state";
+    }
+    if (!state) {
+        return;
+    }
+    if (state == state_ || FindOverlay(state) != M_MAX_UNSIGNED) {
+        throw "Tried to push a state that is already active";
+    }
+
+    bool preloaded = state == preloadState_;
+    if (preloaded) {
+        preloadState_.Reset();
+        preloadReady_ = false;
+    }
+
+    OverlayEntry entry;
+    entry.state_ = state;
+    entry.overlayFlags_ = overlayFlags;
+    entry.suspend_.suspended_ = false;
+    entry.suspend_.flags_ = OVERLAY_RUN_BELOW;
+    if (profiler_) {
+        profiler_->BeginTransition("PushState", GetTopState(), state);
+    }
+    overlays_.Push(entry);
+
+    UpdateSuspension();
+    if (!preloaded) {
+        SendStateEvent(state, E_STATEPRESTART);
+    }
+    SendStateEvent(state, E_STATESTART);
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+void StateManager::PopState()
+{
+    if (internalState_ != NO_TRANSITION) {
+        throw "Tried to pop a state while setting a state";
+    }
+    if (overlays_.Empty()) {
+        throw "Tried to pop a state with no overlay states pushed";
+    }
+
+    SharedPtr<Object> state(overlays_.Back().state_);
+    overlays_.Pop();
+    if (profiler_) {
+        profiler_->BeginTransition("PopState", state, GetTopState());
+    }
+
+    SendStateEvent(state, E_STATEEND);
+    UpdateSuspension();
+    SendStateEvent(state, E_STATEPOSTEND);
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+void StateManager::ReplaceState(Object* state, unsigned overlayFlags)
+{
+    if (overlays_.Empty()) {
+        SetState(state);
+        return;
+    }
+    if (internalState_ != NO_TRANSITION) {
+        throw "Tried to replace a state while setting a state";
+    }
+    if (!state) {
+        PopState();
+        return;
+    }
+    if (state == state_ || FindOverlay(state) != M_MAX_UNSIGNED) {
+        throw "Tried to replace with a state that is already active";
+    }
+
+    bool preloaded = state == preloadState_;
+    if (preloaded) {
+        preloadState_.Reset();
+        preloadReady_ = false;
+    }
+
+    OverlayEntry& top = overlays_.Back();
+    SharedPtr<Object> oldState(top.state_);
+    top.state_ = state;
+    top.overlayFlags_ = overlayFlags;
+    top.suspend_.suspended_ = false;
+    top.suspend_.flags_ = OVERLAY_RUN_BELOW;
+    if (profiler_) {
+        profiler_->BeginTransition("ReplaceState", oldState, state);
+    }
+
+    SendStateEvent(oldState, E_STATEEND);
+    if (!preloaded) {
+        SendStateEvent(state, E_STATEPRESTART);
+    }
+    SendStateEvent(state, E_STATESTART);
+    UpdateSuspension();
+    SendStateEvent(oldState, E_STATEPOSTEND);
+    if (profiler_) {
+        profiler_->EndTransition();
+    }
+}
+
+Object* StateManager::GetTopState()
+{
+    return overlays_.Empty() ? state_.Get() : overlays_.Back().state_.Get();
+}
+
+Object* StateManager::GetOverlay(unsigned index)
+{
+    return index < overlays_.Size() ? overlays_[index].state_.Get() : 0;
+}
+
+void StateManager::ClearOverlays()
+{
+    // The states below are not resumed since they are all going away
+    while (!overlays_.Empty()) {
+        SharedPtr<Object> state(overlays_.Back().state_);
+        overlays_.Pop();
+        SendStateEvent(state, E_STATEEND);
+        SendStateEvent(state, E_STATEPOSTEND);
+    }
+    baseSuspend_.suspended_ = false;
+    baseSuspend_.flags_ = OVERLAY_RUN_BELOW;
+}
+
+unsigned StateManager::FindOverlay(Object* state) const
+{
+    if (state) {
+        for (unsigned i = 0; i < overlays_.Size(); ++i) {
+            if (overlays_[i].state_ == state) {
+                return i;
+            }
+        }
+    }
+    return M_MAX_UNSIGNED;
+}
+
+void StateManager::UpdateSuspension()
+{
+    // Gather first, handlers may well push or pop states themselves
+    Vector<SharedPtr<Object> > changed;
+    PODVector<SuspendState> changedTo;
+
+    SuspendState below;
+    below.suspended_ = false;
+    below.flags_ = OVERLAY_RUN_BELOW;
+    for (unsigned i = overlays_.Size() + 1; i-- > 0;) {
+        SuspendState& current = i > 0 ? overlays_[i - 1].suspend_ : baseSuspend_;
+        Object* state = i > 0 ? overlays_[i - 1].state_.Get() : state_.Get();
+
+        bool differs = current.suspended_ != below.suspended_ || (below.suspended_ && current.flags_ != below.flags_);
+        current = below;
+        if (differs && state) {
+            changed.Push(SharedPtr<Object>(state));
+            changedTo.Push(below);
+        }
+
+        if (i > 0) {
+            below.suspended_ = true;
+            below.flags_ &= overlays_[i - 1].overlayFlags_;
+        }
+    }
+
+    for (unsigned i = 0; i < changed.Size(); ++i) {
+        if (changedTo[i].suspended_) {
+            StateEventArgs args;
+            args.keepUpdating_ = (changedTo[i].flags_ & OVERLAY_UPDATE_BELOW) != 0;
+            args.keepRendering_ = (changedTo[i].flags_ & OVERLAY_RENDER_BELOW) != 0;
+            SendStateEvent(changed[i], E_STATESUSPEND, args);
+        } else {
+            SendStateEvent(changed[i], E_STATERESUME);
+        }
+    }
+}
+
+void StateManager::AddLoadingTask(Object* state, LoadingTask* task)
+{
+    if (!state || !task) {
+        return;
+    }
+
+    task->owner_ = state;
+    loadingTasks_.Push(SharedPtr<LoadingTask>(task));
+    if (loadingTasks_.Size() == 1) {
+        SubscribeToEvent(E_UPDATE, HANDLER(StateManager, HandleLoadingTasksUpdate));
+    }
+    if (!task->gateOnly_) {
+        OptInToAutoComplete(state);
+    }
+}
+
+void StateManager::OptInToAutoComplete(Object* state)
+{
+    if (state == state_) {
+        autoComplete_ = true;
+    }
+    else if (state == preloadState_) {
+        preloadAutoComplete_ = true;
+    }
+}
+
+bool StateManager::HasLoadingTasks(Object* state) const
+{
+    for (unsigned i = 0; i < loadingTasks_.Size(); ++i) {
+        if (loadingTasks_[i]->owner_ == state) {
+            return true;
+        }
+    }
+    for (unsigned i = 0; i < backgroundTasks_.Size(); ++i) {
+        if (!backgroundTasks_[i]->cancelled_ && backgroundTasks_[i]->owner_ == state) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StateManager::CompleteIfLoaded(Object* state)
+{
+    if (!state || HasLoadingTasks(state)) {
+        return;
+    }
+    if ((state == state_ && internalState_ == LOADINGSCREEN && autoComplete_) ||
+        (state == preloadState_ && !preloadReady_ && preloadAutoComplete_)) {
+        PostLoadingComplete(state);
+    }
+}
+
+void StateManager::AddBackgroundTask(Object* state, BackgroundTask* task)
+{
+    if (!state || !task) {
+        return;
+    }
+    if (task->submitted_) {
+        throw "Tried to add a background task that has already been added";
+    }
+    for (unsigned i = 0; i < task->dependencies_.Size(); ++i) {
+        const BackgroundTask* dependency = task->dependencies_[i];
+        if (!dependency->owner_ && !dependency->finished_ && !dependency->cancelled_) {
+            throw "Tried to add a background task before one of its dependencies";
+        }
+    }
+
+    task->owner_ = state;
+    OptInToAutoComplete(state);
+    backgroundTasks_.Push(SharedPtr<BackgroundTask>(task));
+    if (backgroundTasks_.Size() == 1) {
+        SubscribeToEvent(E_WORKITEMCOMPLETED, HANDLER(StateManager, HandleWorkItemCompleted));
+    }
+    if (task->IsBlocked()) {
+        DropBlockedBackgroundTasks();
+    }
+    else if (task->IsReady()) {
+        SubmitBackgroundTask(task);
+    }
+}
+
+void StateManager::SubmitBackgroundTask(BackgroundTask* task)
+{
+    task->submitted_ = true;
+
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    if (!queue || !queue->GetNumThreads()) {
+        // No worker threads to hand it to so just do it now
+        task->Process();
+        FinishBackgroundTask(task);
+        return;
+    }
+
+    SharedPtr<WorkItem> item(new WorkItem());
+    item->workFunction_ = ProcessBackgroundTask;
+    item->aux_ = task;
+    item->sendEvent_ = true;
+    queue->AddWorkItem(item);
+}
+
+void StateManager::FinishBackgroundTask(BackgroundTask* task)
+{
+    SharedPtr<BackgroundTask> holder(task);
+    backgroundTasks_.Remove(holder);
+    if (backgroundTasks_.Empty()) {
+        UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
+    }
+    if (task->cancelled_) {
+        return;
+    }
+
+    task->Finish();
+    task->finished_ = true;
+
+    WeakPtr<Object> owner(task->owner_);
+    if (owner.Get() == state_.Get()) {
+        ++loadingTasksDone_;
+        if (internalState_ == LOADINGSCREEN) {
+            SendLoadingProgress();
+        }
+    }
+
+    // Start everything that was only waiting on this one, submitting may
+    // finish a task right away and change the list so look again after each
+    bool submitted = true;
+    while (submitted) {
+        submitted = false;
+        for (unsigned i = 0; i < backgroundTasks_.Size(); ++i) {
+            BackgroundTask* waiting = backgroundTasks_[i];
+            if (!waiting->submitted_ && waiting->IsReady()) {
+                SubmitBackgroundTask(waiting);
+                submitted = true;
+                break;
+            }
+        }
+    }
+
+    CompleteIfLoaded(owner);
+}
+
+void StateManager::DropBlockedBackgroundTasks()
+{
+    // Dropping one may block others that depend on it, so repeat until none
+    Vector<WeakPtr<Object> > owners;
+    bool dropped = true;
+    while (dropped) {
+        dropped = false;
+        for (unsigned i = backgroundTasks_.Size(); i-- > 0;) {
+            SharedPtr<BackgroundTask> task(backgroundTasks_[i]);
+            if (task->submitted_ || !task->IsBlocked()) {
+                continue;
+            }
+            LOGWARNING("Dropped background task " + task->GetLabel() + " as a dependency of it will never finish");
+            task->cancelled_ = true;
+            backgroundTasks_.Erase(i);
+            if (!owners.Contains(task->owner_)) {
+                owners.Push(task->owner_);
+            }
+            dropped = true;
+        }
+    }
+    if (backgroundTasks_.Empty()) {
+        UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
+    }
+
+    for (unsigned i = 0; i < owners.Size(); ++i) {
+        CompleteIfLoaded(owners[i]);
+    }
+}
+
+void StateManager::HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData)
+{
+    using namespace WorkItemCompleted;
+
+    WorkItem* item = static_cast<WorkItem*>(eventData[P_ITEM].GetVoidPtr());
+    if (!item || item->workFunction_ != ProcessBackgroundTask) {
+        return;
+    }
+
+    for (unsigned i = 0; i < backgroundTasks_.Size(); ++i) {
+        if (backgroundTasks_[i] == item->aux_) {
+            FinishBackgroundTask(backgroundTasks_[i]);
+            return;
+        }
+    }
+}
+
+void StateManager::RemoveLoadingTasks(Object* state)
+{
+    if (!state) {
+        return;
+    }
+    for (unsigned i = loadingTasks_.Size(); i-- > 0;) {
+        if (loadingTasks_[i]->owner_ == state) {
+            loadingTasks_.Erase(i);
+        }
+    }
+    for (unsigned i = backgroundTasks_.Size(); i-- > 0;) {
+        BackgroundTask* task = backgroundTasks_[i];
+        if (task->owner_ != state) {
+            continue;
+        }
+        // A worker may be running it, so hold it until it completes
+        task->cancelled_ = true;
+        if (!task->submitted_) {
+            backgroundTasks_.Erase(i);
+        }
+    }
+    // Tasks of other states may have been waiting on those
+    DropBlockedBackgroundTasks();
+}
+
+void StateManager::HandleLoadingTasksUpdate(StringHash eventType, VariantMap& eventData)
+{
+    HiresTimer timer;
+    long long budget = (long long)(loadingTaskBudget_ * 1000.0f);
+    Vector<WeakPtr<Object> > finishedStates;
+    bool ranLoadingState = false;
+
+    // Each state's tasks run in order, a waiting state only holds up itself
+    PODVector<Object*> waitingStates;
+    unsigned i = 0;
+    while (i < loadingTasks_.Size()) {
+        SharedPtr<LoadingTask> task(loadingTasks_[i]);
+        Object* owner = task->owner_;
+        if (!owner) {
+            loadingTasks_.Erase(i);
+            continue;
+        }
+        if (waitingStates.Contains(owner)) {
+            ++i;
+            continue;
+        }
+
+        if (owner == state_) {
+            ranLoadingState = true;
+        }
+        LoadingTaskResult result = task->Run();
+        if (result == LOADING_TASK_WAIT) {
+            waitingStates.Push(owner);
+            ++i;
+        } else if (result == LOADING_TASK_DONE) {
+            task->progress_ = 1.0f;
+            // The task may have queued more tasks, or the state may be gone
+            loadingTasks_.Remove(task);
+            if (owner == state_) {
+                ++loadingTasksDone_;
+            }
+            if (!HasLoadingTasks(owner)) {
+                finishedStates.Push(WeakPtr<Object>(owner));
+            }
+            i = 0;
+        } else if (i >= loadingTasks_.Size() || loadingTasks_[i] != task) {
+            i = 0;
+        }
+
+        if (timer.GetUSec(false) >= budget) {
+            break;
+        }
+    }
+
+    if (ranLoadingState && internalState_ == LOADINGSCREEN) {
+        SendLoadingProgress();
+    }
+
+    if (loadingTasks_.Empty()) {
+        UnsubscribeFromEvent(E_UPDATE);
+    }
+
+    for (unsigned i = 0; i < finishedStates.Size(); ++i) {
+        CompleteIfLoaded(finishedStates[i]);
+    }
+}
+
+void StateManager::SendLoadingProgress()
+{
+    if (!loadingState_) {
+        return;
+    }
+
+    LoadingTask* current = 0;
+    unsigned remaining = 0;
+    for (unsigned i = 0; i < loadingTasks_.Size(); ++i) {
+        if (loadingTasks_[i]->owner_ == state_) {
+            if (!current) {
+                current = loadingTasks_[i];
+            }
+            ++remaining;
+        }
+    }
+    for (unsigned i = 0; i < backgroundTasks_.Size(); ++i) {
+        if (!backgroundTasks_[i]->cancelled_ && backgroundTasks_[i]->owner_ == state_) {
+            ++remaining;
+        }
+    }
+
+    unsigned numTasks = loadingTasksDone_ + remaining;
+    float taskProgress = current ? current->GetProgress() : 1.0f;
+
+    StateEventArgs args;
+    args.taskIndex_ = current ? loadingTasksDone_ : numTasks;
+    args.numTasks_ = numTasks;
+    args.taskProgress_ = taskProgress;
+    args.progress_ = numTasks ? ((float)loadingTasksDone_ + (current ? taskProgress : 0.0f)) / (float)numTasks : 1.0f;
+    args.label_ = current ? &current->GetLabel() : &String::EMPTY;
+    SendStateEvent(loadingState_, E_STATELOADINGPROGRESS, args);
+}
+
+void StateManager::PostLoadingUpdate(Object* state, String msg)
+{
+    // Nothing is showing the loading of a preloading state, or of a stale one
+    if (state != state_) {
+        return;
+    }
+    PostLoadingUpdate(msg);
+}
+
 void StateManager::PostLoadingUpdate(String msg)
 {
     if (loadingState_) {
-        using namespace StateLoadingUpdate;
-        VariantMap& eventData = context_->GetEventDataMap();
-        eventData[P_MESSAGE] = msg;
-        loadingState_->SendEvent(E_STATELOADINGUPDATE, eventData);
+        StateEventArgs args;
+        args.message_ = &msg;
+        SendStateEvent(loadingState_, E_STATELOADINGUPDATE, args);
     }
 }
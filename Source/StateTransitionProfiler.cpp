@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/StateTransitionProfiler.hpp"
+#include "Urho3D-OverLib/StateManager.hpp"
+
+#include <cstdio>
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/IO/File.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+static String GetStateEventName(StringHash eventType)
+{
+    if (eventType == E_STATEPRESTART) return "StatePreStart";
+    if (eventType == E_STATESTART) return "StateStart";
+    if (eventType == E_STATEEND) return "StateEnd";
+    if (eventType == E_STATEPOSTEND) return "StatePostEnd";
+    if (eventType == E_STATELOADINGSTART) return "StateLoadingStart";
+    if (eventType == E_STATELOADINGEND) return "StateLoadingEnd";
+    if (eventType == E_STATELOADINGUPDATE) return "StateLoadingUpdate";
+    if (eventType == E_STATELOADINGPROGRESS) return "StateLoadingProgress";
+    if (eventType == E_STATEPRELOADED) return "StatePreloaded";
+    if (eventType == E_STATESUSPEND) return "StateSuspend";
+    if (eventType == E_STATERESUME) return "StateResume";
+    return eventType.ToString();
+}
+
+/// Type names are identifiers so nothing in them needs escaping
+static void AppendTraceEvent(String& trace, const String& name, long long start, long long duration, const char* argName, const String& argValue)
+{
+    char buffer[128];
+    sprintf(buffer, "\", \"cat\": \"StateManager\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %lld, \"dur\": %lld", start, duration);
+
+    if (trace.Length() > 0 && trace.Back() == '}') {
+        trace += ",\n";
+    }
+    trace += "        { \"name\": \"" + name + buffer;
+    if (argName) {
+        trace += ", \"args\": { \"" + String(argName) + "\": \"" + argValue + "\" }";
+    }
+    trace += " }";
+}
+
+StateTransitionProfiler::StateTransitionProfiler(Context* context)
+    : Object(context)
+    , nextRecord_(0)
+    , numRecords_(0)
+    , depth_(0)
+    , current_(0)
+{
+    records_.Resize(16);
+}
+
+StateTransitionProfiler::~StateTransitionProfiler()
+{
+}
+
+void StateTransitionProfiler::SetMaxTransitions(unsigned count)
+{
+    if (!count) {
+        throw "Tried to set the maximum transitions of a profiler to zero";
+    }
+    records_.Clear();
+    records_.Resize(count);
+    Clear();
+}
+
+void StateTransitionProfiler::Clear()
+{
+    for (unsigned i = 0; i < records_.Size(); ++i) {
+        records_[i].events_.Clear();
+    }
+    nextRecord_ = 0;
+    numRecords_ = 0;
+    // A running transition is dropped, what is left of it is not recorded
+    current_ = 0;
+    UnsubscribeFromEvent(E_BEGINFRAME);
+}
+
+const StateTransition& StateTransitionProfiler::GetTransition(unsigned index) const
+{
+    if (index >= numRecords_) {
+        throw "Tried to get a state transition past the number recorded";
+    }
+    unsigned first = nextRecord_ + records_.Size() - numRecords_;
+    return records_[(first + index) % records_.Size()];
+}
+
+String StateTransitionProfiler::GetChromeTrace() const
+{
+    String trace = "{\n    \"traceEvents\": [\n";
+    for (unsigned i = 0; i < numRecords_; ++i) {
+        const StateTransition& transition = GetTransition(i);
+        if (!transition.finished_) {
+            continue;
+        }
+
+        AppendTraceEvent(trace, transition.kind_ + " " + transition.oldState_ + " -> " + transition.newState_,
+            transition.start_, transition.duration_, 0, String::EMPTY);
+        if (transition.loadingDuration_ > 0) {
+            AppendTraceEvent(trace, "Loading", transition.loadingStart_, transition.loadingDuration_,
+                "frames", String(transition.loadingFrames_));
+        }
+        for (unsigned j = 0; j < transition.events_.Size(); ++j) {
+            const StateTransitionEvent& event = transition.events_[j];
+            AppendTraceEvent(trace, GetStateEventName(event.eventType_), event.start_, event.duration_,
+                "sender", event.sender_);
+        }
+    }
+    trace += "\n    ],\n    \"displayTimeUnit\": \"ms\"\n}\n";
+    return trace;
+}
+
+bool StateTransitionProfiler::SaveChromeTrace(const String& fileName) const
+{
+    File file(context_, fileName, FILE_WRITE);
+    if (!file.IsOpen()) {
+        return false;
+    }
+    String trace = GetChromeTrace();
+    return file.Write(trace.CString(), trace.Length()) == trace.Length();
+}
+
+void StateTransitionProfiler::BeginTransition(const String& kind, Object* oldState, Object* newState)
+{
+    if (depth_++ > 0) {
+        return;
+    }
+
+    current_ = &records_[nextRecord_];
+    nextRecord_ = (nextRecord_ + 1) % records_.Size();
+    if (numRecords_ < records_.Size()) {
+        ++numRecords_;
+    }
+
+    current_->kind_ = kind;
+    current_->oldState_ = oldState ? oldState->GetTypeName() : "None";
+    current_->newState_ = newState ? newState->GetTypeName() : "None";
+    current_->start_ = GetTime();
+    current_->duration_ = 0;
+    current_->loadingStart_ = -1;
+    current_->loadingDuration_ = 0;
+    current_->loadingFrames_ = 0;
+    current_->finished_ = false;
+    current_->events_.Clear();
+}
+
+void StateTransitionProfiler::EndTransition()
+{
+    if (!depth_ || --depth_ > 0) {
+        return;
+    }
+    if (current_) {
+        current_->duration_ = GetTime() - current_->start_;
+        current_->finished_ = true;
+        current_ = 0;
+    }
+}
+
+void StateTransitionProfiler::BeginLoading()
+{
+    if (!current_) {
+        return;
+    }
+    current_->loadingStart_ = GetTime();
+    SubscribeToEvent(E_BEGINFRAME, HANDLER(StateTransitionProfiler, HandleBeginFrame));
+}
+
+void StateTransitionProfiler::EndLoading()
+{
+    UnsubscribeFromEvent(E_BEGINFRAME);
+    if (current_ && current_->loadingStart_ >= 0) {
+        current_->loadingDuration_ = GetTime() - current_->loadingStart_;
+    }
+}
+
+void StateTransitionProfiler::RecordEvent(Object* sender, StringHash eventType, long long start)
+{
+    if (!current_) {
+        return;
+    }
+    StateTransitionEvent event;
+    event.eventType_ = eventType;
+    event.sender_ = sender->GetTypeName();
+    event.start_ = start;
+    event.duration_ = GetTime() - start;
+    current_->events_.Push(event);
+}
+
+void StateTransitionProfiler::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    if (current_) {
+        ++current_->loadingFrames_;
+    }
+}
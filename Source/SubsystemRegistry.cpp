@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "Urho3D-OverLib/SubsystemRegistry.hpp"
+
+#include <cstdio>
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/MathDefs.h>
+
+using namespace Urho3D;
+using namespace OverLib;
+
+
+namespace
+{
+
+struct ParallelInitialize
+{
+    SubsystemInitializer* initializer_;
+    long long time_;
+};
+
+}
+
+static void RunInitializeAsync(ParallelInitialize* init)
+{
+    HiresTimer timer;
+    init->initializer_->InitializeAsync();
+    init->time_ = timer.GetUSec(false);
+}
+
+static void InitializeSubsystem(const WorkItem* item, unsigned threadIndex)
+{
+    RunInitializeAsync(static_cast<ParallelInitialize*>(item->aux_));
+}
+
+SubsystemRegistry::SubsystemRegistry(Context* context)
+    : Object(context)
+    , totalTime_(0)
+{
+}
+
+SubsystemRegistry::~SubsystemRegistry()
+{
+}
+
+void SubsystemRegistry::Register(StringHash type, const String& typeName, SubsystemFactory* factory)
+{
+    // Held straight away so it is not leaked by the throw
+    SharedPtr<SubsystemFactory> held(factory);
+
+    unsigned index = FindEntry(type);
+    if (index != M_MAX_UNSIGNED) {
+        if (entries_[index].created_) {
+            throw "Tried to register a subsystem that has already been created";
+        }
+        entries_[index].factory_ = held;
+        return;
+    }
+
+    Entry entry;
+    entry.factory_ = held;
+    entry.timing_.type_ = type;
+    entry.timing_.typeName_ = typeName;
+    entry.timing_.level_ = 0;
+    entry.timing_.createTime_ = 0;
+    entry.timing_.initializeTime_ = 0;
+    entry.timing_.finishTime_ = 0;
+    entry.timing_.existed_ = false;
+    entry.created_ = false;
+    entries_.Push(entry);
+}
+
+void SubsystemRegistry::DependsOn(StringHash type, StringHash dependency)
+{
+    unsigned index = FindEntry(type);
+    if (index == M_MAX_UNSIGNED) {
+        throw "Tried to add a dependency to a subsystem that is not registered";
+    }
+    if (!entries_[index].dependencies_.Contains(dependency)) {
+        entries_[index].dependencies_.Push(dependency);
+    }
+}
+
+void SubsystemRegistry::Initialize()
+{
+    HiresTimer total;
+    unsigned numLevels = ComputeLevels();
+    WorkQueue* queue = GetSubsystem<WorkQueue>();
+    bool threaded = queue && queue->GetNumThreads() > 0;
+
+    for (unsigned level = 0; level < numLevels; ++level) {
+        // Created on the main thread, the Context is not thread safe
+        PODVector<unsigned> created;
+        PODVector<SubsystemInitializer*> initializers;
+        for (unsigned i = 0; i < entries_.Size(); ++i) {
+            Entry& entry = entries_[i];
+            if (entry.created_ || entry.timing_.level_ != level) {
+                continue;
+            }
+
+            entry.created_ = true;
+            entry.timing_.existed_ = context_->GetSubsystem(entry.timing_.type_) != 0;
+            HiresTimer timer;
+            Object* subsystem = entry.factory_->Create(context_);
+            entry.timing_.createTime_ = timer.GetUSec(false);
+
+            SubsystemInitializer* initializer = entry.timing_.existed_ ? 0 : dynamic_cast<SubsystemInitializer*>(subsystem);
+            if (initializer) {
+                created.Push(i);
+                initializers.Push(initializer);
+            }
+        }
+
+        // Sized up front, the work items point in to it
+        PODVector<ParallelInitialize> inits(initializers.Size());
+        Vector<SharedPtr<WorkItem> > items;
+        for (unsigned i = 0; i < initializers.Size(); ++i) {
+            inits[i].initializer_ = initializers[i];
+            inits[i].time_ = 0;
+
+            // The main thread takes the first one itself
+            if (threaded && i > 0) {
+                SharedPtr<WorkItem> item(new WorkItem());
+                item->workFunction_ = InitializeSubsystem;
+                item->aux_ = &inits[i];
+                item->priority_ = M_MAX_UNSIGNED;
+                queue->AddWorkItem(item);
+                items.Push(item);
+            }
+        }
+        if (!inits.Empty()) {
+            RunInitializeAsync(&inits[0]);
+        }
+        for (unsigned i = 1; i < inits.Size() && !threaded; ++i) {
+            RunInitializeAsync(&inits[i]);
+        }
+        // Only ours, WorkQueue::Complete would also run (and send the
+        // completion events of) everything else queued
+        for (unsigned i = 0; i < items.Size(); ++i) {
+            while (!items[i]->completed_) {
+                Time::Sleep(0);
+            }
+        }
+
+        for (unsigned i = 0; i < inits.Size(); ++i) {
+            SubsystemTiming& timing = entries_[created[i]].timing_;
+            timing.initializeTime_ = inits[i].time_;
+            HiresTimer timer;
+            inits[i].initializer_->FinishInitialize();
+            timing.finishTime_ = timer.GetUSec(false);
+        }
+    }
+    totalTime_ = total.GetUSec(false);
+}
+
+String SubsystemRegistry::GetTimingReport() const
+{
+    unsigned numLevels = 0;
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        numLevels = Max(numLevels, entries_[i].timing_.level_ + 1);
+    }
+
+    char line[256];
+    sprintf(line, "%-32s %5s %12s %12s %12s\n", "Subsystem", "Level", "Create ms", "Async ms", "Finish ms");
+    String report(line);
+    for (unsigned level = 0; level < numLevels; ++level) {
+        for (unsigned i = 0; i < entries_.Size(); ++i) {
+            const SubsystemTiming& timing = entries_[i].timing_;
+            if (!entries_[i].created_ || timing.level_ != level) {
+                continue;
+            }
+            sprintf(line, "%-32s %5u %12.3f %12.3f %12.3f%s\n", timing.typeName_.CString(), timing.level_,
+                timing.createTime_ / 1000.0, timing.initializeTime_ / 1000.0, timing.finishTime_ / 1000.0,
+                timing.existed_ ? " (existed)" : "");
+            report += line;
+        }
+    }
+    sprintf(line, "Total %.3f ms\n", totalTime_ / 1000.0);
+    report += line;
+    return report;
+}
+
+unsigned SubsystemRegistry::ComputeLevels()
+{
+    // Created entries are level zero as far as the rest is concerned, every
+    // other one is a level above its highest dependency
+    PODVector<bool> assigned(entries_.Size());
+    unsigned numAssigned = 0;
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        assigned[i] = entries_[i].created_;
+        if (assigned[i]) {
+            ++numAssigned;
+        }
+    }
+
+    unsigned numLevels = 0;
+    while (numAssigned < entries_.Size()) {
+        bool progress = false;
+        for (unsigned i = 0; i < entries_.Size(); ++i) {
+            if (assigned[i]) {
+                continue;
+            }
+
+            Entry& entry = entries_[i];
+            unsigned level = 0;
+            bool ready = true;
+            for (unsigned j = 0; j < entry.dependencies_.Size() && ready; ++j) {
+                unsigned dependency = FindEntry(entry.dependencies_[j]);
+                if (dependency == M_MAX_UNSIGNED) {
+                    if (!context_->GetSubsystem(entry.dependencies_[j])) {
+                        throw "Tried to initialize a subsystem depending on one that is neither registered nor created";
+                    }
+                } else if (!assigned[dependency]) {
+                    ready = false;
+                } else if (!entries_[dependency].created_) {
+                    level = Max(level, entries_[dependency].timing_.level_ + 1);
+                }
+            }
+
+            if (ready) {
+                entry.timing_.level_ = level;
+                assigned[i] = true;
+                ++numAssigned;
+                numLevels = Max(numLevels, level + 1);
+                progress = true;
+            }
+        }
+        if (!progress) {
+            throw "Tried to initialize subsystems that depend on each other in a cycle";
+        }
+    }
+    return numLevels;
+}
+
+unsigned SubsystemRegistry::FindEntry(StringHash type) const
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i) {
+        if (entries_[i].timing_.type_ == type) {
+            return i;
+        }
+    }
+    return M_MAX_UNSIGNED;
+}
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D
+{
+class Serializable;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %AttributeEditJournal records attribute edits as deltas for undo and redo,
+/// by default every E_ATTRIBUTEEDITCOMMITTED, the old and new values are
+/// serialized back to back in to one buffer instead of held as Variants, and
+/// a run of edits to the same attribute is kept as a single edit
+class URHO3D_API AttributeEditJournal : public Urho3D::Object
+{
+    OBJECT(AttributeEditJournal);
+
+public:
+    /// Construct.
+    AttributeEditJournal(Urho3D::Context* context);
+    /// Destruct.
+    ~AttributeEditJournal();
+
+public:
+    /// Record an edit already made to the target, anything that could be
+    /// redone is dropped
+    void Record(Urho3D::Serializable* target, unsigned int index, const Urho3D::Variant& oldValue, const Urho3D::Variant& newValue);
+
+    /// Undo the last edit, or group of edits, returns false if there was none
+    bool Undo();
+    /// Redo the last undone edit, or group of edits
+    bool Redo();
+    bool CanUndo() const { return position_ > 0; }
+    bool CanRedo() const { return position_ < entries_.Size(); }
+
+    /// Edits recorded until the matching EndGroup are undone as one, groups
+    /// can nest
+    void BeginGroup();
+    void EndGroup();
+    /// The next edit is kept separate even if it is to the same attribute
+    void BreakCoalescing() { coalesce_ = false; }
+    void Clear();
+
+    /// Oldest edits are dropped to stay below this many bytes
+    void SetMaxMemory(unsigned bytes);
+    unsigned GetMaxMemory() const { return maxMemory_; }
+    unsigned GetMemoryUse() const;
+    /// Number of recorded edits, done and undone
+    unsigned GetNumEdits() const { return entries_.Size(); }
+    /// Number of edits currently done
+    unsigned GetPosition() const { return position_; }
+
+private:
+    struct Entry {
+        unsigned object_;
+        unsigned index_;
+        /// Old value, then the new value from newOffset_, in the arena
+        unsigned offset_;
+        unsigned newOffset_;
+        unsigned group_;
+    };
+
+    unsigned GetObjectId(Urho3D::Serializable* target);
+    void TruncateRedo();
+    void ApplyEntries(unsigned begin, unsigned end, bool newValues);
+    Urho3D::Variant ReadValue(unsigned offset) const;
+    void EnforceMemoryLimit();
+    /// Drop the objects no edit refers to any more, after edits were dropped
+    void CompactObjects();
+    void HandleEditCommitted(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::VectorBuffer arena_;
+    Urho3D::PODVector<Entry> entries_;
+    unsigned position_;
+    Urho3D::Vector<Urho3D::WeakPtr<Urho3D::Serializable> > objects_;
+    Urho3D::HashMap<Urho3D::Serializable*, unsigned> objectIds_;
+    unsigned nextGroup_;
+    unsigned groupDepth_;
+    unsigned group_;
+    bool coalesce_;
+    /// Set while undoing or redoing so the writes are not recorded again
+    bool applying_;
+    unsigned maxMemory_;
+};
+
+}
+
+}
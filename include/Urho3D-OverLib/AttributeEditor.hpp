@@ -23,13 +23,21 @@
 #pragma once
 
 #include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/RefCounted.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/Variant.h>
+#include <Urho3D/Math/StringHash.h>
+
+#include "Urho3D-OverLib/AttributeEditorTraits.hpp"
 
 namespace Urho3D
 {
 class AttributeInfo;
+class Button;
 class Context;
 class EventHandler;
 class LineEdit;
+class Serializable;
 class String;
 class UIElement;
 class Variant;
@@ -45,18 +53,112 @@ namespace OverLib
 namespace AttributeEditor
 {
 
+/// Fixed height of every attribute editor row
+const unsigned int ATTR_HEIGHT = 19;
+/// Shown in place of values that differ between the objects being edited
+const char* const STRIKED_OUT = "——";
+
+/// %Binding holds direct pointers to the value widgets of attribute editors,
+/// indexed by attribute index, so whole sets of attributes can be loaded and
+/// saved without searching the UI tree
+class URHO3D_API Binding : public Urho3D::RefCounted
+{
+public:
+    /// Construct.
+    Binding();
+    /// Destruct.
+    ~Binding();
+
+    /// Bind an editor made by CreateAttributeEditor to the attribute index
+    bool Register(const Urho3D::AttributeInfo& info, unsigned int index, Urho3D::UIElement* editor);
+    void Unregister(unsigned int index);
+    void Clear();
+
+    /// Set every bound editor from the source's attributes
+    void LoadAll(Urho3D::Serializable* source);
+    /// Write every bound editor that differs back to the target, returns the
+    /// number of attributes written
+    unsigned SaveAll(Urho3D::Serializable* target);
+    /// Set every bound editor from the attributes of all the sources, showing
+    /// a striked out placeholder where they differ, a CheckBox shows the first
+    /// source's value
+    void LoadAll(const Urho3D::PODVector<Urho3D::Serializable*>& sources);
+    /// Write every bound editor to all the targets, a striked out placeholder
+    /// or an untouched mixed CheckBox keeps each target's own value, returns
+    /// the number of attributes written over all the targets
+    unsigned SaveAll(const Urho3D::PODVector<Urho3D::Serializable*>& targets);
+
+    bool IsBound(unsigned int index) const;
+    void SetValue(unsigned int index, const Urho3D::Variant& fromValue);
+    Urho3D::Variant GetValue(unsigned int index, const Urho3D::Variant& toValueWithDefault) const;
+    /// The editor given to Register for the attribute index
+    Urho3D::UIElement* GetEditor(unsigned int index) const;
+    unsigned GetNumBound() const { return entries_.Size(); }
+    /// Attribute index of the n-th bound editor, in no particular order
+    unsigned GetBoundIndex(unsigned n) const { return entries_[n].index_; }
+    /// The widgets that edit the value, such as each LineEdit of a Vector3
+    void GetValueWidgets(unsigned int index, Urho3D::PODVector<Urho3D::UIElement*>& dest) const;
+
+private:
+    struct Entry {
+        unsigned int index_;
+        Urho3D::VariantType type_;
+        Urho3D::SharedPtr<Urho3D::UIElement> editor_;
+        /// CheckBox, DropDownList, LineEdit, or the container of coordinates
+        Urho3D::UIElement* value_;
+        Urho3D::LineEdit* coords_[MAX_NUM_COORDS];
+        unsigned numCoords_;
+        /// Numeric editing of the type when coords_ are used
+        const NumAttributeOps* ops_;
+    };
+
+    const Entry* GetEntry(unsigned int index) const;
+    static void SetEntryValue(const Entry& entry, const Urho3D::Variant& fromValue);
+    static void SetEntryMixedValue(const Entry& entry, const Urho3D::Vector<Urho3D::Variant>& fromValues);
+    static Urho3D::Variant GetEntryValue(const Entry& entry, const Urho3D::Variant& toValueWithDefault);
+    /// True if every coordinate of a numeric editor still shows the text the
+    /// value formats to, or is striked out, so it was not edited
+    static bool ShowsValue(const Entry& entry, const Urho3D::Variant& value);
+
+    Urho3D::Vector<Entry> entries_;
+    /// Attribute index to entries_ index, or M_MAX_UNSIGNED when unbound
+    Urho3D::PODVector<unsigned> indexToEntry_;
+};
+
 Urho3D::SharedPtr<Urho3D::UIElement> CreateAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);//, Urho3D::EventHandler* handler);
 
+/// Create the editor and register it in to the binding
+Urho3D::SharedPtr<Urho3D::UIElement> CreateAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex, Binding* binding);
+
 Urho3D::SharedPtr<Urho3D::UIElement> CreateBoolAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);//, Urho3D::EventHandler* handler);
 
 Urho3D::SharedPtr<Urho3D::UIElement> CreateNumAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);//, Urho3D::EventHandler* handler);
 
 Urho3D::SharedPtr<Urho3D::UIElement> CreateStringAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);//, Urho3D::EventHandler* handler);
 
+/// VariantVector, VariantMap, ResourceRefList and Buffer editors, the entries
+/// only get editors when expanded
+Urho3D::SharedPtr<Urho3D::UIElement> CreateContainerAttributeEditor(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);
+
 Urho3D::SharedPtr<Urho3D::UIElement> CreateAttributeEditorParent(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::String& name, unsigned int index, unsigned int subIndex);
 
 Urho3D::SharedPtr<Urho3D::LineEdit> CreateAttributeLineEdit(Urho3D::Context* context, Urho3D::XMLFile* style, const Urho3D::String& name, unsigned int index, unsigned int subIndex);
 
+/// Name of the drag slider button in a numeric LineEdit
+const char* const DRAG_SLIDER_NAME = "DragSlider";
+
+/// Add a button to the right of the LineEdit that scrubs its number when
+/// dragged, the Drag events are sent from the button, see AttributeEditorPanel
+Urho3D::SharedPtr<Urho3D::Button> CreateDragSlider(Urho3D::LineEdit* edit);
+
+/// Editors with the same shape have the same widget tree and can be rebound
+/// to each other's attributes
+Urho3D::StringHash GetAttributeEditorShape(const Urho3D::AttributeInfo& info);
+/// Point an existing editor at another attribute of the same shape, renaming
+/// its widgets and resetting their Index and SubIndex vars, the value is left
+/// for SetValue
+bool RebindAttributeEditor(Urho3D::UIElement* editor, const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);
+
 void SetValue(Urho3D::UIElement* toElement, const Urho3D::Variant& fromValue);
 Urho3D::Variant GetValue(const Urho3D::Variant& toValueWithDefault, const Urho3D::UIElement* fromElement);
 
@@ -0,0 +1,146 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include "Urho3D-OverLib/AttributeEditor.hpp"
+#include "Urho3D-OverLib/AttributeEditorPool.hpp"
+#include "Urho3D-OverLib/AttributeWriteCoalescer.hpp"
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %AttributeEditCommitted is sent by an AttributeEditorPanel once for every
+/// finished edit it wrote, a whole drag is a single edit
+EVENT(E_ATTRIBUTEEDITCOMMITTED, AttributeEditCommitted)
+{
+    PARAM(P_SERIALIZABLE, Serializable); // Serializable pointer
+    PARAM(P_INDEX, Index);               // unsigned, attribute index
+    PARAM(P_OLDVALUE, OldValue);         // Variant
+    PARAM(P_NEWVALUE, NewValue);         // Variant
+}
+
+/// %AttributeEditorPanel binds a set of attribute editors to one Serializable
+/// and keeps the two in sync incrementally, only attributes the user edited
+/// are written back and only widgets whose source value changed are updated
+class URHO3D_API AttributeEditorPanel : public Urho3D::Object
+{
+    OBJECT(AttributeEditorPanel);
+
+public:
+    /// Construct.
+    AttributeEditorPanel(Urho3D::Context* context);
+    /// Destruct.
+    ~AttributeEditorPanel();
+
+public:
+    /// Set the Serializable being edited, the editors are reloaded from it
+    void SetTarget(Urho3D::Serializable* target);
+    Urho3D::Serializable* GetTarget() const;
+
+    /// Create editors for every editable attribute of the target and add them
+    /// to the container, as items if it is a ListView
+    void Populate(Urho3D::XMLFile* style, Urho3D::UIElement* container, unsigned int subIndex = 0);
+    /// Take over an editor made by CreateAttributeEditor
+    bool AddEditor(const Urho3D::AttributeInfo& info, unsigned int index, Urho3D::UIElement* editor);
+    /// Forget every editor, without a pool the UI elements themselves are left
+    /// alone, with one the editors made by Populate are released to it
+    void Clear();
+
+    /// Check the editors out of the pool in Populate instead of creating them
+    void SetPool(AttributeEditorPool* pool) { pool_ = pool; }
+    AttributeEditorPool* GetPool() const { return pool_; }
+
+    /// Write only the edited attributes to the target, returns how many were
+    /// written
+    unsigned Apply();
+    /// Update only the editors whose attribute changed in the target since it
+    /// was last shown, edited attributes are left alone, cheap enough for
+    /// every frame, returns how many editors were updated
+    unsigned Refresh();
+    /// Throw away every edit and reload all the editors from the target
+    void Revert();
+    /// Take an attribute the target had written by something other than the
+    /// panel, its edit (if any) is dropped, its editor reloaded and the write
+    /// is sent as E_ATTRIBUTEEDITCOMMITTED
+    void CommitWritten(unsigned int index, const Urho3D::Variant& oldValue);
+
+    /// Write edits to the target as soon as they are made
+    void SetAutoApply(bool enable) { autoApply_ = enable; }
+    bool GetAutoApply() const { return autoApply_; }
+
+    /// Change of a dragged number per pixel
+    void SetDragSensitivity(float sensitivity) { dragSensitivity_ = sensitivity; }
+    float GetDragSensitivity() const { return dragSensitivity_; }
+    /// Writes made while dragging go through this, so they can be rate limited
+    AttributeWriteCoalescer* GetWriteCoalescer() const { return coalescer_; }
+
+    bool IsDirty(unsigned int index) const;
+    bool HasDirty() const { return !dirtyList_.Empty(); }
+
+    AttributeEditor::Binding* GetBinding() const { return binding_; }
+
+private:
+    void HandleEdited(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleDragBegin(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleDragMove(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleDragEnd(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleDragCancel(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void SendEditCommitted(unsigned int index, const Urho3D::Variant& oldValue, const Urho3D::Variant& newValue);
+    /// Set the editor and remember the value as shown, without it counting as
+    /// an edit
+    void ShowValue(unsigned int index, const Urho3D::Variant& value);
+    void MarkDirty(unsigned int index);
+    void ClearDirty();
+
+private:
+    Urho3D::SharedPtr<AttributeEditor::Binding> binding_;
+    Urho3D::WeakPtr<Urho3D::Serializable> target_;
+    Urho3D::SharedPtr<AttributeEditorPool> pool_;
+    /// Where Populate put the editors
+    Urho3D::WeakPtr<Urho3D::UIElement> container_;
+    /// Per attribute index, the target's value as last shown in its editor
+    Urho3D::Vector<Urho3D::Variant> shownValues_;
+    Urho3D::PODVector<bool> dirty_;
+    Urho3D::PODVector<unsigned> dirtyList_;
+    bool autoApply_;
+    /// Set while ShowValue writes an editor
+    bool showing_;
+
+    Urho3D::SharedPtr<AttributeWriteCoalescer> coalescer_;
+    float dragSensitivity_;
+    /// The coordinate being dragged, if any
+    Urho3D::WeakPtr<Urho3D::LineEdit> dragEdit_;
+    unsigned dragIndex_;
+    float dragBase_;
+    int dragDelta_;
+    Urho3D::Variant dragOldValue_;
+};
+
+}
+
+}
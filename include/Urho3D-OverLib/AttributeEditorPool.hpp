@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+class AttributeInfo;
+class UIElement;
+class XMLFile;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %AttributeEditorPool keeps released attribute editors of one style, by
+/// editor shape, so making an editor is a rebind of an already styled one
+/// instead of building and styling a new widget tree
+class URHO3D_API AttributeEditorPool : public Urho3D::Object
+{
+    OBJECT(AttributeEditorPool);
+
+public:
+    /// Construct.
+    AttributeEditorPool(Urho3D::Context* context, Urho3D::XMLFile* style = 0);
+    /// Destruct.
+    ~AttributeEditorPool();
+
+public:
+    /// Change the style, pooled editors of the old style are dropped
+    void SetStyle(Urho3D::XMLFile* style);
+    Urho3D::XMLFile* GetStyle() const;
+
+    /// Get an editor for the attribute, rebound from the pool if one of its
+    /// shape is there, else created, null if there is no editor for the type
+    Urho3D::SharedPtr<Urho3D::UIElement> Checkout(const Urho3D::AttributeInfo& info, unsigned int index, unsigned int subIndex);
+    /// Return an editor from Checkout, it is removed from its parent
+    void Release(Urho3D::UIElement* editor);
+    /// Create editors of the attribute's shape until count are pooled
+    void Prewarm(const Urho3D::AttributeInfo& info, unsigned count);
+    /// Drop every pooled editor
+    void Clear();
+
+    /// Number of pooled editors of the attribute's shape
+    unsigned GetNumPooled(const Urho3D::AttributeInfo& info) const;
+    unsigned GetNumPooled() const;
+
+private:
+    typedef Urho3D::Vector<Urho3D::SharedPtr<Urho3D::UIElement> > EditorList;
+
+    Urho3D::SharedPtr<Urho3D::XMLFile> style_;
+    Urho3D::HashMap<Urho3D::StringHash, EditorList> pool_;
+};
+
+}
+
+}
@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdio>
+
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Variant.h>
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+namespace AttributeEditor
+{
+
+/// Long enough for any formatted int or float coordinate
+const unsigned NUM_TEXT_LENGTH = 32;
+/// Most coordinates a numeric editor can have
+const unsigned MAX_NUM_COORDS = 4;
+
+inline void FormatNumComponent(float value, char* text) { sprintf(text, "%g", value); }
+inline void FormatNumComponent(int value, char* text) { sprintf(text, "%d", value); }
+inline void ParseNumComponent(const char* text, float& dest) { dest = Urho3D::ToFloat(text); }
+inline void ParseNumComponent(const char* text, int& dest) { dest = Urho3D::ToInt(text); }
+
+/// %NumAttributeTraits describe a numeric VariantType edited as a LineEdit
+/// per coordinate, ComponentType, NUM_COORDS, GetComponents and
+/// FromComponents are all a type needs, user types follow the same form
+template <Urho3D::VariantType Type> struct NumAttributeTraits;
+
+template <> struct NumAttributeTraits<Urho3D::VAR_INT>
+{
+    typedef int ComponentType;
+    enum { NUM_COORDS = 1 };
+    static void GetComponents(const Urho3D::Variant& value, int* dest) { dest[0] = value.GetInt(); }
+    static Urho3D::Variant FromComponents(const int* src) { return src[0]; }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_FLOAT>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 1 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { dest[0] = value.GetFloat(); }
+    static Urho3D::Variant FromComponents(const float* src) { return src[0]; }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_VECTOR2>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 2 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { const float* src = value.GetVector2().Data(); dest[0] = src[0]; dest[1] = src[1]; }
+    static Urho3D::Variant FromComponents(const float* src) { return Urho3D::Vector2(src); }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_VECTOR3>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 3 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { const float* src = value.GetVector3().Data(); dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; }
+    static Urho3D::Variant FromComponents(const float* src) { return Urho3D::Vector3(src); }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_VECTOR4>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 4 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { const float* src = value.GetVector4().Data(); dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; dest[3] = src[3]; }
+    static Urho3D::Variant FromComponents(const float* src) { return Urho3D::Vector4(src); }
+};
+
+/// Edited as euler angles, same as a 3 value string parses to
+template <> struct NumAttributeTraits<Urho3D::VAR_QUATERNION>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 3 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { Urho3D::Vector3 euler = value.GetQuaternion().EulerAngles(); dest[0] = euler.x_; dest[1] = euler.y_; dest[2] = euler.z_; }
+    static Urho3D::Variant FromComponents(const float* src) { return Urho3D::Quaternion(src[0], src[1], src[2]); }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_COLOR>
+{
+    typedef float ComponentType;
+    enum { NUM_COORDS = 4 };
+    static void GetComponents(const Urho3D::Variant& value, float* dest) { const float* src = value.GetColor().Data(); dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; dest[3] = src[3]; }
+    static Urho3D::Variant FromComponents(const float* src) { return Urho3D::Color(src[0], src[1], src[2], src[3]); }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_INTVECTOR2>
+{
+    typedef int ComponentType;
+    enum { NUM_COORDS = 2 };
+    static void GetComponents(const Urho3D::Variant& value, int* dest) { const int* src = value.GetIntVector2().Data(); dest[0] = src[0]; dest[1] = src[1]; }
+    static Urho3D::Variant FromComponents(const int* src) { return Urho3D::IntVector2(src[0], src[1]); }
+};
+
+template <> struct NumAttributeTraits<Urho3D::VAR_INTRECT>
+{
+    typedef int ComponentType;
+    enum { NUM_COORDS = 4 };
+    static void GetComponents(const Urho3D::Variant& value, int* dest) { const int* src = value.GetIntRect().Data(); dest[0] = src[0]; dest[1] = src[1]; dest[2] = src[2]; dest[3] = src[3]; }
+    static Urho3D::Variant FromComponents(const int* src) { return Urho3D::IntRect(src[0], src[1], src[2], src[3]); }
+};
+
+/// Format every coordinate of the value in to the texts
+template <class Traits> void FormatNumCoords(const Urho3D::Variant& value, char (*texts)[NUM_TEXT_LENGTH])
+{
+    typename Traits::ComponentType components[Traits::NUM_COORDS];
+    Traits::GetComponents(value, components);
+    for (unsigned i = 0; i < Traits::NUM_COORDS; ++i) {
+        FormatNumComponent(components[i], texts[i]);
+    }
+}
+
+/// Parse the coordinate texts in to a value, a null text keeps that
+/// coordinate of the base value
+template <class Traits> Urho3D::Variant ParseNumCoords(const char* const* texts, const Urho3D::Variant& base)
+{
+    typename Traits::ComponentType components[Traits::NUM_COORDS];
+    bool needBase = false;
+    for (unsigned i = 0; i < Traits::NUM_COORDS; ++i) {
+        if (texts[i])
+            ParseNumComponent(texts[i], components[i]);
+        else
+            needBase = true;
+    }
+
+    if (needBase) {
+        typename Traits::ComponentType baseComponents[Traits::NUM_COORDS];
+        Traits::GetComponents(base, baseComponents);
+        for (unsigned i = 0; i < Traits::NUM_COORDS; ++i) {
+            if (!texts[i]) {
+                components[i] = baseComponents[i];
+            }
+        }
+    }
+    return Traits::FromComponents(components);
+}
+
+/// %NumAttributeOps is the type erased form of a NumAttributeTraits, looked up
+/// once per attribute
+struct NumAttributeOps
+{
+    typedef void (*FormatFunction)(const Urho3D::Variant& value, char (*texts)[NUM_TEXT_LENGTH]);
+    typedef Urho3D::Variant (*ParseFunction)(const char* const* texts, const Urho3D::Variant& base);
+
+    unsigned numCoords_;
+    FormatFunction format_;
+    ParseFunction parse_;
+};
+
+template <class Traits> NumAttributeOps MakeNumAttributeOps()
+{
+    NumAttributeOps ops;
+    ops.numCoords_ = Traits::NUM_COORDS;
+    ops.format_ = &FormatNumCoords<Traits>;
+    ops.parse_ = &ParseNumCoords<Traits>;
+    return ops;
+}
+
+/// The numeric editing of the type, null if it is not edited as numbers
+URHO3D_API const NumAttributeOps* GetNumAttributeOps(Urho3D::VariantType type);
+/// Edit the type as numbers, such as VAR_DOUBLE, or replace how one is edited
+URHO3D_API void RegisterNumAttributeType(Urho3D::VariantType type, const NumAttributeOps& ops);
+
+template <class Traits> void RegisterNumAttributeType(Urho3D::VariantType type)
+{
+    RegisterNumAttributeType(type, MakeNumAttributeOps<Traits>());
+}
+
+}
+
+}
+
+}
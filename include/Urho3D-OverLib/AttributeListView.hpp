@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include "Urho3D-OverLib/AttributeEditorPool.hpp"
+
+namespace Urho3D
+{
+class ListView;
+class Serializable;
+class UIElement;
+class XMLFile;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %AttributeListView fills a ListView with attribute editors for one or more
+/// Serializables, but only creates editors for the rows that are in view,
+/// the rest are stood in for by two spacers, and rows scrolled out of view
+/// are rebound to the attributes scrolled in to view, so the element count
+/// follows the size of the view and not the number of attributes, every row
+/// is taken to be ATTR_HEIGHT high so expanded containers throw it off
+class URHO3D_API AttributeListView : public Urho3D::Object
+{
+    OBJECT(AttributeListView);
+
+public:
+    /// Construct.
+    AttributeListView(Urho3D::Context* context);
+    /// Destruct.
+    ~AttributeListView();
+
+public:
+    /// Take over the ListView, any items in it are removed
+    void SetListView(Urho3D::ListView* view, Urho3D::XMLFile* style);
+    Urho3D::ListView* GetListView() const;
+    /// Share a pool of editors with other views, its style is set to the
+    /// view's, by default each view has its own
+    void SetPool(AttributeEditorPool* pool);
+    AttributeEditorPool* GetPool() const { return pool_; }
+
+    /// Edit a single Serializable
+    void SetTarget(Urho3D::Serializable* target);
+    /// Edit the editable attributes of every target, one after another, the
+    /// SubIndex of each row is the index of its target
+    void SetTargets(const Urho3D::PODVector<Urho3D::Serializable*>& targets);
+    void AddTarget(Urho3D::Serializable* target);
+    void ClearTargets();
+    unsigned GetNumTargets() const { return targets_.Size(); }
+    Urho3D::Serializable* GetTarget(unsigned int subIndex) const;
+
+    /// Refill the rows in view from their targets, rows being edited are left
+    /// alone
+    void Refresh();
+
+    /// Total number of attribute rows
+    unsigned GetNumRows() const { return rows_.Size(); }
+    /// Number of rows that currently have an editor
+    unsigned GetNumVisibleRows() const { return editors_.Size(); }
+
+private:
+    struct Row {
+        unsigned subIndex_;
+        unsigned index_;
+    };
+
+    void RebuildRows();
+    /// Bind editors to the rows in view, force rebinds every row
+    void UpdateWindow(bool force);
+    void ReleaseAll();
+    Urho3D::SharedPtr<Urho3D::UIElement> Checkout(const Row& row);
+    void Release(Urho3D::UIElement* editor);
+    void SubscribeToEditor(Urho3D::UIElement* editor, bool subscribe);
+    void FillEditor(Urho3D::UIElement* editor, const Row& row);
+    void HandleViewChanged(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleEdited(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::WeakPtr<Urho3D::ListView> view_;
+    Urho3D::SharedPtr<Urho3D::XMLFile> style_;
+    Urho3D::SharedPtr<Urho3D::UIElement> topSpacer_;
+    Urho3D::SharedPtr<Urho3D::UIElement> bottomSpacer_;
+    Urho3D::Vector<Urho3D::WeakPtr<Urho3D::Serializable> > targets_;
+    Urho3D::PODVector<Row> rows_;
+    /// Editors of the rows from firstRow_ on that are in view
+    Urho3D::Vector<Urho3D::SharedPtr<Urho3D::UIElement> > editors_;
+    unsigned firstRow_;
+    Urho3D::SharedPtr<AttributeEditorPool> pool_;
+    bool updating_;
+};
+
+}
+
+}
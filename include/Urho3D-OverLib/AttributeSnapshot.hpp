@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+
+namespace Urho3D
+{
+class Deserializer;
+class Serializable;
+class Serializer;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+namespace AttributeEditor
+{
+class Binding;
+}
+
+class AttributeEditorPanel;
+
+/// What an AttributeSnapshot captures
+enum AttributeSnapshotMode {
+    /// Every editable attribute
+    SNAPSHOT_FULL = 0,
+    /// Only the attributes that differ from their defaults, the others are
+    /// set back to their defaults when applied
+    SNAPSHOT_DIFF
+};
+
+/// %AttributeSnapshot is a compact binary copy of the editable attributes of
+/// a Serializable, keyed by attribute name hash so attributes added, removed
+/// or retyped since it was saved are skipped instead of breaking the load,
+/// the values are only decoded when applied
+class URHO3D_API AttributeSnapshot : public Urho3D::Object
+{
+    OBJECT(AttributeSnapshot);
+
+public:
+    /// Construct.
+    AttributeSnapshot(Urho3D::Context* context);
+    /// Destruct.
+    ~AttributeSnapshot();
+
+public:
+    /// Replace the snapshot with the source's editable attributes
+    void Capture(Urho3D::Serializable* source, AttributeSnapshotMode mode = SNAPSHOT_FULL);
+    /// Set every attribute of the target the snapshot has a value of the same
+    /// type for, in one pass over its attributes, only writing those that
+    /// differ and setting the bound editors as well, returns how many were
+    /// written
+    unsigned Apply(Urho3D::Serializable* target, AttributeEditor::Binding* binding = 0) const;
+    /// Apply to the panel's target through the panel, so its editors and
+    /// edits stay current and every write is sent as E_ATTRIBUTEEDITCOMMITTED
+    /// for an AttributeEditJournal to undo
+    unsigned Apply(AttributeEditorPanel* panel) const;
+    void Clear();
+
+    bool Save(Urho3D::Serializer& dest) const;
+    bool Save(const Urho3D::String& fileName) const;
+    /// Load a snapshot from the rest of the source, false and empty if it is
+    /// not one or is of a newer version
+    bool Load(Urho3D::Deserializer& source);
+    /// Load a snapshot file with a single read
+    bool Load(const Urho3D::String& fileName);
+
+    AttributeSnapshotMode GetMode() const { return mode_; }
+    unsigned GetNumValues() const { return entries_.Size(); }
+    bool HasValue(Urho3D::StringHash nameHash) const;
+    /// The value for the attribute name, empty if there is none
+    Urho3D::Variant GetValue(Urho3D::StringHash nameHash) const;
+    /// The snapshot as saved
+    const Urho3D::PODVector<unsigned char>& GetData() const { return data_.GetBuffer(); }
+
+private:
+    struct Entry {
+        unsigned nameHash_;
+        /// Of the value, from valuesOffset_
+        unsigned offset_;
+
+        bool operator <(const Entry& rhs) const { return nameHash_ < rhs.nameHash_; }
+    };
+
+    /// Write data_ from the entries, sorted, and their values
+    void Build(AttributeSnapshotMode mode, const Urho3D::PODVector<Entry>& entries, const Urho3D::VectorBuffer& values);
+    /// Read the header and the entry table of data_
+    bool Parse();
+    /// The single pass of Apply, the indices written and their old values are
+    /// added to the lists if given
+    unsigned Write(Urho3D::Serializable* target, AttributeEditor::Binding* binding, Urho3D::PODVector<unsigned>* indices, Urho3D::Vector<Urho3D::Variant>* oldValues) const;
+    unsigned FindEntry(Urho3D::StringHash nameHash) const;
+    Urho3D::Variant ReadValue(const Entry& entry) const;
+
+private:
+    /// Header, entry table sorted by name hash, then the values
+    Urho3D::VectorBuffer data_;
+    Urho3D::PODVector<Entry> entries_;
+    unsigned valuesOffset_;
+    AttributeSnapshotMode mode_;
+};
+
+}
+
+}
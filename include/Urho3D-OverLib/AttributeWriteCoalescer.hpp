@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+class Serializable;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %AttributeWriteCoalescer holds back attribute writes that come in faster
+/// than they are worth applying, such as while dragging, only the latest
+/// value of each attribute is kept and it is written at most once a frame,
+/// or less often with a rate limit
+class URHO3D_API AttributeWriteCoalescer : public Urho3D::Object
+{
+    OBJECT(AttributeWriteCoalescer);
+
+public:
+    /// Construct.
+    AttributeWriteCoalescer(Urho3D::Context* context);
+    /// Destruct, anything still queued is written.
+    ~AttributeWriteCoalescer();
+
+public:
+    /// Replace any queued value of the attribute, written on a later update
+    void Queue(Urho3D::Serializable* target, unsigned int index, const Urho3D::Variant& value);
+    /// Write the queued value of the attribute now, if any, and forget it
+    void Flush(Urho3D::Serializable* target, unsigned int index);
+    void FlushAll();
+    /// Drop the queued value of the attribute without writing it
+    void Cancel(Urho3D::Serializable* target, unsigned int index);
+
+    /// Most writes per second of one attribute, 0 for once every frame
+    void SetMaxWritesPerSecond(float rate) { maxWritesPerSecond_ = rate; }
+    float GetMaxWritesPerSecond() const { return maxWritesPerSecond_; }
+
+    unsigned GetNumQueued() const { return writes_.Size(); }
+    bool IsQueued(Urho3D::Serializable* target, unsigned int index) const;
+
+private:
+    struct PendingWrite {
+        Urho3D::WeakPtr<Urho3D::Serializable> target_;
+        unsigned index_;
+        Urho3D::Variant value_;
+        /// Elapsed time of the last write of the attribute
+        float lastWriteTime_;
+        bool dirty_;
+    };
+
+    unsigned Find(Urho3D::Serializable* target, unsigned int index) const;
+    void Write(PendingWrite& write, float time);
+    void Remove(unsigned i);
+    float GetTime() const;
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    /// Only a few attributes are ever in flight, so a plain search will do
+    Urho3D::Vector<PendingWrite> writes_;
+    float maxWritesPerSecond_;
+};
+
+}
+
+}
@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+
+#include "Urho3D-OverLib/LoadingTask.hpp"
+
+namespace Urho3D
+{
+class Resource;
+class XMLFile;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %BatchLoadProgress is sent by a BatchLoader at most once per frame while
+/// any of its resources finished loading that frame
+EVENT(E_BATCHLOADPROGRESS, BatchLoadProgress)
+{
+    PARAM(P_BATCH, Batch);   // BatchLoader pointer
+    PARAM(P_LOADED, Loaded); // unsigned
+    PARAM(P_FAILED, Failed); // unsigned
+    PARAM(P_TOTAL, Total);   // unsigned
+    PARAM(P_BYTES, Bytes);   // unsigned, memory use of the loaded resources
+}
+
+/// %BatchLoadComplete is sent by a BatchLoader once every resource in it has
+/// either loaded or failed
+EVENT(E_BATCHLOADCOMPLETE, BatchLoadComplete)
+{
+    PARAM(P_BATCH, Batch);   // BatchLoader pointer
+    PARAM(P_LOADED, Loaded); // unsigned
+    PARAM(P_FAILED, Failed); // unsigned
+    PARAM(P_TOTAL, Total);   // unsigned
+    PARAM(P_BYTES, Bytes);   // unsigned
+}
+
+/// %BatchLoader background loads a set of resources and reports on them as a
+/// whole instead of once per resource
+class URHO3D_API BatchLoader : public Urho3D::Object
+{
+    OBJECT(BatchLoader);
+
+public:
+    /// Construct.
+    BatchLoader(Urho3D::Context* context);
+    /// Destruct.
+    ~BatchLoader();
+
+public:
+    /// Add a resource to the batch, must be called before Start
+    void AddResource(Urho3D::StringHash type, const Urho3D::String& name);
+    template <class T> void AddResource(const Urho3D::String& name)
+    {
+        AddResource(T::GetTypeStatic(), name);
+    }
+
+    /// Add every `<resource type="" name="" />` child of the manifest root
+    bool AddManifest(Urho3D::XMLFile* manifest);
+    /// Load the named manifest XMLFile through the ResourceCache then add it
+    bool AddManifest(const Urho3D::String& manifestName);
+
+    /// Submit everything to the ResourceCache background queue, events are
+    /// sent from the next frame onward so subscribe to them before or after
+    void Start();
+
+    bool IsStarted() const { return started_; }
+    bool IsComplete() const { return started_ && loaded_ + failed_ == entries_.Size(); }
+
+    unsigned GetNumTotal() const { return entries_.Size(); }
+    unsigned GetNumLoaded() const { return loaded_; }
+    unsigned GetNumFailed() const { return failed_; }
+    unsigned GetNumBytes() const { return bytes_; }
+    float GetProgress() const;
+
+    /// Keep a reference to every resource as it is loaded, so releasing it
+    /// elsewhere without forcing does not unload it, turning it off lets go
+    void SetHoldResources(bool enable);
+    bool GetHoldResources() const { return holdResources_; }
+
+    /// True if the resource was added, the name need not be sanitated
+    bool HasResource(Urho3D::StringHash type, const Urho3D::String& name) const;
+    Urho3D::StringHash GetResourceType(unsigned index) const { return entries_[index].type_; }
+    /// Sanitated name of the resource
+    const Urho3D::String& GetResourceName(unsigned index) const { return entries_[index].name_; }
+
+private:
+    void HandleResourceBackgroundLoaded(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+    void MarkDone(unsigned index, Urho3D::Resource* resource);
+    void SendProgressEvent(Urho3D::StringHash eventType);
+
+private:
+    enum EntryState {
+        ENTRY_WAITING,
+        ENTRY_PENDING,
+        ENTRY_LOADED,
+        ENTRY_FAILED
+    };
+
+    struct Entry {
+        Urho3D::StringHash type_;
+        Urho3D::String name_;
+        EntryState state_;
+        /// Set once loaded while holding resources
+        Urho3D::SharedPtr<Urho3D::Resource> resource_;
+        /// Next entry sharing the same resource name, or M_MAX_UNSIGNED
+        unsigned nextSameName_;
+    };
+
+    Urho3D::Vector<Entry> entries_;
+    /// Sanitated resource name to the first entry using that name
+    Urho3D::HashMap<Urho3D::StringHash, unsigned> nameToEntry_;
+
+    unsigned loaded_;
+    unsigned failed_;
+    unsigned bytes_;
+    bool started_;
+    bool dirty_;
+    bool holdResources_;
+};
+
+/// %BatchLoadingTask is a LoadingTask that starts a BatchLoader and waits for
+/// it to complete, its progress is that of the batch
+class URHO3D_API BatchLoadingTask : public LoadingTask
+{
+public:
+    /// Construct.
+    BatchLoadingTask(BatchLoader* loader, const Urho3D::String& label);
+
+    virtual LoadingTaskResult Run();
+
+    BatchLoader* GetLoader() const { return loader_; }
+
+private:
+    Urho3D::SharedPtr<BatchLoader> loader_;
+};
+
+}
+
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/Variant.h>
+#include <Urho3D/UI/UIElement.h>
+
+namespace Urho3D
+{
+class CheckBox;
+class Text;
+class XMLFile;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %ContainerAttributeEdit is the value widget of a VariantVector, VariantMap,
+/// ResourceRefList or Buffer attribute editor, collapsed it only holds the
+/// value and a summary, the editors for the entries are created when it is
+/// expanded, nested containers are collapsed again so only the opened levels
+/// ever get widgets, edits to any entry are sent on as a TextFinished from
+/// this element
+class URHO3D_API ContainerAttributeEdit : public Urho3D::UIElement
+{
+    OBJECT(ContainerAttributeEdit);
+
+public:
+    /// Construct.
+    ContainerAttributeEdit(Urho3D::Context* context);
+    /// Destruct.
+    ~ContainerAttributeEdit();
+
+    /// Create the expand toggle and summary, call once it has a default style
+    void Setup(Urho3D::VariantType type);
+
+    void SetValue(const Urho3D::Variant& value);
+    /// The value, rebuilt from the entry editors when expanded
+    Urho3D::Variant GetValue(const Urho3D::Variant& toValueWithDefault) const;
+    /// Show values that differ between objects, nothing can be expanded
+    /// until the next SetValue
+    void SetMixed();
+    bool IsMixed() const { return mixed_; }
+
+    void SetExpanded(bool enable);
+    bool IsExpanded() const { return expanded_; }
+
+private:
+    void UpdateSummary();
+    void CreateEntries();
+    void RemoveEntries();
+    /// Flatten the value to entry values and names
+    void GetEntries(Urho3D::Vector<Urho3D::Variant>& values, Urho3D::Vector<Urho3D::String>& names) const;
+    void HandleToggled(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleEntryEdited(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::VariantType type_;
+    Urho3D::Variant value_;
+    Urho3D::SharedPtr<Urho3D::CheckBox> toggle_;
+    Urho3D::SharedPtr<Urho3D::Text> summary_;
+    Urho3D::SharedPtr<Urho3D::UIElement> entries_;
+    /// Entry value widgets in entry order, null for entries with no editor
+    Urho3D::PODVector<Urho3D::UIElement*> entryValues_;
+    bool expanded_;
+    bool mixed_;
+};
+
+}
+
+}
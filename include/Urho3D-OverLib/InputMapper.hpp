@@ -0,0 +1,231 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+class StateManager;
+
+/// Keys that must also be held for a binding to count, such as Ctrl for Ctrl+S
+const unsigned MAX_CHORD_KEYS = 2;
+
+enum InputBindingType {
+    BINDING_KEY,
+    BINDING_MOUSEBUTTON,
+    BINDING_JOYSTICKBUTTON,
+    BINDING_JOYSTICKAXIS,
+    MAX_BINDING_TYPES
+};
+
+/// One raw input an action is bound to
+struct InputBinding
+{
+    InputBindingType type_;
+    /// Key, mouse button, joystick button or joystick axis
+    int code_;
+    int joystickId_;
+    /// Axis positions are multiplied by this, buttons are 0 or 1
+    float scale_;
+    /// Axis positions closer to zero than this are zero
+    float deadZone_;
+    /// Zero for none
+    int chordKeys_[MAX_CHORD_KEYS];
+};
+
+/// %InputContext is a layer of action bindings, usually owned by a state, the
+/// InputMapper combines the layers into one flat table whenever they change
+class URHO3D_API InputContext : public Urho3D::RefCounted
+{
+public:
+    /// Construct.
+    InputContext(const Urho3D::String& name = Urho3D::String::EMPTY);
+    /// Destruct.
+    ~InputContext();
+
+public:
+    void Bind(Urho3D::StringHash action, const InputBinding& binding);
+    void BindKey(Urho3D::StringHash action, int key, int chordKey = 0, int chordKey2 = 0);
+    void BindMouseButton(Urho3D::StringHash action, int button);
+    void BindJoystickButton(Urho3D::StringHash action, int button, int joystickId = 0);
+    void BindJoystickAxis(Urho3D::StringHash action, int axis, float scale = 1.0f, float deadZone = 0.2f, int joystickId = 0);
+    /// Remove every binding of the action
+    void Unbind(Urho3D::StringHash action);
+    void Clear();
+
+    /// A blocking context hides every context below it, not just the actions
+    /// it binds itself
+    void SetBlocking(bool enable);
+    bool IsBlocking() const { return blocking_; }
+
+    const Urho3D::String& GetName() const { return name_; }
+    unsigned GetNumBindings() const { return bindings_.Size(); }
+    Urho3D::StringHash GetBindingAction(unsigned index) const { return bindings_[index].action_; }
+    const InputBinding& GetBinding(unsigned index) const { return bindings_[index].binding_; }
+    /// Bumped on every change so the InputMapper knows to recompile
+    unsigned GetVersion() const { return version_; }
+
+private:
+    struct ActionBinding {
+        Urho3D::StringHash action_;
+        InputBinding binding_;
+    };
+
+    Urho3D::String name_;
+    Urho3D::Vector<ActionBinding> bindings_;
+    bool blocking_;
+    unsigned version_;
+};
+
+/// %InputMapper turns raw input into named actions, raw input events are kept
+/// as they arrive and the actions are sampled from them once per frame in to a
+/// flat array, so reading an action by its index costs an array lookup
+class URHO3D_API InputMapper : public Urho3D::Object
+{
+    OBJECT(InputMapper);
+    friend class StateManager;
+
+public:
+    /// Construct.
+    InputMapper(Urho3D::Context* context);
+    /// Destruct.
+    ~InputMapper();
+
+public:
+    /// Dense index of the action, the same for the life of the mapper, actions
+    /// bound in any context are registered as they are compiled
+    unsigned RegisterAction(const Urho3D::String& name);
+    unsigned RegisterAction(Urho3D::StringHash action);
+    /// M_MAX_UNSIGNED if the action is not registered
+    unsigned GetActionIndex(Urho3D::StringHash action) const;
+    unsigned GetNumActions() const { return actions_.Size(); }
+
+    /// Unknown indices are never down
+    bool IsActionDown(unsigned index) const { return index < actions_.Size() && actions_[index].down_; }
+    /// Down this frame but not the frame before
+    bool IsActionPressed(unsigned index) const { return index < actions_.Size() && actions_[index].down_ && !actions_[index].wasDown_; }
+    bool IsActionReleased(unsigned index) const { return index < actions_.Size() && !actions_[index].down_ && actions_[index].wasDown_; }
+    /// Signed axis value, or 0 and 1 for buttons
+    float GetActionValue(unsigned index) const { return index < actions_.Size() ? actions_[index].value_ : 0.0f; }
+    bool IsActionDown(Urho3D::StringHash action) const { return IsActionDown(GetActionIndex(action)); }
+    bool IsActionPressed(Urho3D::StringHash action) const { return IsActionPressed(GetActionIndex(action)); }
+    bool IsActionReleased(Urho3D::StringHash action) const { return IsActionReleased(GetActionIndex(action)); }
+    float GetActionValue(Urho3D::StringHash action) const { return GetActionValue(GetActionIndex(action)); }
+
+    /// Push a context above all the others, the owner is for RemoveContexts
+    void PushContext(InputContext* context, Urho3D::Object* owner = 0);
+    void RemoveContext(InputContext* context);
+    void RemoveContexts(Urho3D::Object* owner);
+    unsigned GetNumContexts() const { return contexts_.Size(); }
+
+    /// The context of a state is pushed when the state is sent E_STATESTART and
+    /// removed on its E_STATEEND, see StateObject::SetInputContext
+    void SetStateContext(Urho3D::Object* state, InputContext* context);
+    InputContext* GetStateContext(Urho3D::Object* state) const;
+
+    /// Actions whose absolute value reaches this are down
+    void SetPressThreshold(float threshold) { pressThreshold_ = threshold; }
+    float GetPressThreshold() const { return pressThreshold_; }
+
+    /// Update the actions from the raw input, done on every E_BEGINFRAME after
+    /// the Input subsystem has sent the frame's events, call it directly to
+    /// sample synthetic input events without running frames
+    void Sample();
+    /// Release every raw input, done when the window loses input focus
+    void ResetInput();
+
+private:
+    /// Rebuild the flat binding table from the context stack
+    void Compile();
+    unsigned GetRawSlot(InputBindingType type, int code, int joystickId);
+    void SetRawInput(InputBindingType type, int code, int joystickId, float value);
+    void HandleKeyDown(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleKeyUp(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleMouseButtonDown(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleMouseButtonUp(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleJoystickButtonDown(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleJoystickButtonUp(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleJoystickAxisMove(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleInputFocus(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleBeginFrame(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    /// Called by the StateManager as it starts and ends states, instead of
+    /// subscribing to every state's events
+    void StartStateContext(Urho3D::Object* state);
+    void EndStateContext(Urho3D::Object* state);
+
+private:
+    struct ActionState {
+        float value_;
+        bool down_;
+        bool wasDown_;
+        /// Range of the action's bindings in compiled_
+        unsigned first_;
+        unsigned count_;
+    };
+
+    struct CompiledBinding {
+        unsigned slot_;
+        /// M_MAX_UNSIGNED for none
+        unsigned chordSlots_[MAX_CHORD_KEYS];
+        float scale_;
+        float deadZone_;
+    };
+
+    struct ContextEntry {
+        Urho3D::SharedPtr<InputContext> context_;
+        Urho3D::WeakPtr<Urho3D::Object> owner_;
+        /// Version of the context when last compiled
+        unsigned version_;
+    };
+
+    struct StateContext {
+        Urho3D::WeakPtr<Urho3D::Object> state_;
+        Urho3D::SharedPtr<InputContext> context_;
+    };
+
+    Urho3D::PODVector<ActionState> actions_;
+    Urho3D::HashMap<Urho3D::StringHash, unsigned> actionIndices_;
+    Urho3D::PODVector<CompiledBinding> compiled_;
+    /// Bottom first
+    Urho3D::Vector<ContextEntry> contexts_;
+    Urho3D::Vector<StateContext> stateContexts_;
+
+    /// Latest value of every raw input seen or bound, slots are never reused
+    /// so held input survives a recompile
+    Urho3D::PODVector<float> rawInputs_;
+    Urho3D::HashMap<unsigned, unsigned> rawSlots_[MAX_BINDING_TYPES];
+
+    float pressThreshold_;
+    bool dirty_;
+};
+
+}
+
+}
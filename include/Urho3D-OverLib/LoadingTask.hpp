@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/RefCounted.h>
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+
+namespace Urho3D
+{
+class Object;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+class StateManager;
+
+enum LoadingTaskResult {
+    /// Finished, the next task runs
+    LOADING_TASK_DONE,
+    /// Call again as soon as there is time left this frame
+    LOADING_TASK_MORE,
+    /// Waiting on something else (such as background loads), call next frame
+    LOADING_TASK_WAIT
+};
+
+/// %LoadingTask is a resumable piece of a state's loading, the StateManager
+/// runs the queued tasks in order, calling Run as often as fits in its time
+/// budget each frame, until they are done
+class URHO3D_API LoadingTask : public Urho3D::RefCounted
+{
+public:
+    /// Construct, the label is passed on to the loading state
+    LoadingTask(const Urho3D::String& label);
+    /// Destruct.
+    virtual ~LoadingTask();
+
+    /// Do a small slice of work, return LOADING_TASK_MORE until all done
+    virtual LoadingTaskResult Run() = 0;
+
+    /// Fraction of this task done so far, from 0 to 1
+    float GetProgress() const { return progress_; }
+    void SetProgress(float progress) { progress_ = progress; }
+    const Urho3D::String& GetLabel() const { return label_; }
+    void SetLabel(const Urho3D::String& label) { label_ = label; }
+    /// The state this task is loading for
+    Urho3D::Object* GetOwner() const;
+
+private:
+    friend class StateManager;
+
+    Urho3D::String label_;
+    Urho3D::WeakPtr<Urho3D::Object> owner_;
+    float progress_;
+    /// Only holds back the state's completion, such as its manifest, the
+    /// state is not completed for it having finished
+    bool gateOnly_;
+};
+
+/// %LoadingTaskImpl calls a member function of the receiver as the task
+template <class T> class LoadingTaskImpl : public LoadingTask
+{
+public:
+    typedef LoadingTaskResult (T::*FunctionPtr)(LoadingTask* task);
+
+    /// Construct.
+    LoadingTaskImpl(T* receiver, FunctionPtr function, const Urho3D::String& label)
+        : LoadingTask(label)
+        , receiver_(receiver)
+        , function_(function)
+    {
+    }
+
+    virtual LoadingTaskResult Run()
+    {
+        T* receiver = receiver_.Get();
+        return receiver ? (receiver->*function_)(this) : LOADING_TASK_DONE;
+    }
+
+private:
+    Urho3D::WeakPtr<T> receiver_;
+    FunctionPtr function_;
+};
+
+/// %BackgroundTask is a piece of a state's loading that is run on a WorkQueue
+/// thread, Process must not touch the scene, UI, or anything else that is not
+/// thread safe, that belongs in Finish which is called on the main thread
+class URHO3D_API BackgroundTask : public Urho3D::RefCounted
+{
+public:
+    /// Construct.
+    BackgroundTask(const Urho3D::String& label);
+    /// Destruct.
+    virtual ~BackgroundTask();
+
+    /// Do the work, called on a worker thread
+    virtual void Process() = 0;
+    /// Hand the results over, called on the main thread after Process
+    virtual void Finish();
+
+    /// Do not start until the given task has been processed and finished,
+    /// must be called before the task is added to the StateManager, and the
+    /// dependency has to be added to it first
+    void AddDependency(BackgroundTask* task);
+    bool IsFinished() const { return finished_; }
+
+    const Urho3D::String& GetLabel() const { return label_; }
+    /// The state this task is loading for
+    Urho3D::Object* GetOwner() const;
+
+private:
+    friend class StateManager;
+
+    bool IsReady() const;
+    /// A dependency will never finish, it was dropped or its state is gone
+    bool IsBlocked() const;
+
+    Urho3D::String label_;
+    Urho3D::WeakPtr<Urho3D::Object> owner_;
+    Urho3D::Vector<Urho3D::SharedPtr<BackgroundTask> > dependencies_;
+    bool submitted_;
+    bool finished_;
+    /// The owning state ended, or it was dropped, before it finished
+    bool cancelled_;
+};
+
+}
+
+}
+
+/// Make a loading task from a member function of the current class
+#define LOADINGTASK(className, function, label) (new Urho3D::OverLib::LoadingTaskImpl<className>(this, &className::function, label))
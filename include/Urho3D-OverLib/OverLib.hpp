@@ -25,6 +25,9 @@
 #include <Urho3D/Core/Object.h>
 #include <Urho3D/Resource/ResourceCache.h>
 
+#include "Urho3D-OverLib/ResourceScopes.hpp"
+#include "Urho3D-OverLib/ResourceTelemetry.hpp"
+
 namespace Urho3D
 {
 
@@ -33,6 +36,30 @@ namespace OverLib
 
 class StateManager;
 
+/// %CachedSubsystem is the pointer slot of one subsystem type, so finding it
+/// again skips the hash lookup of Context::GetSubsystem
+template <class T> struct CachedSubsystem
+{
+    /// Null if not cached for the context or since destroyed, removing a
+    /// subsystem that is still held elsewhere does not clear it
+    static T* Get(Urho3D::Context* context)
+    {
+        return context == context_ ? subsystem_.Get() : 0;
+    }
+
+    static void Set(Urho3D::Context* context, T* subsystem)
+    {
+        context_ = context;
+        subsystem_ = subsystem;
+    }
+
+    static Urho3D::Context* context_;
+    static Urho3D::WeakPtr<T> subsystem_;
+};
+
+template <class T> Urho3D::Context* CachedSubsystem<T>::context_ = 0;
+template <class T> Urho3D::WeakPtr<T> CachedSubsystem<T>::subsystem_;
+
 class OverLib
 {
 public:
@@ -40,15 +67,31 @@ public:
     OverLib(Urho3D::Context* context);
 
 public:
-    // TODO: If adding C++11+ then add perfect forwarding to the constructor
     /// Helper to create a subsystem
     template <class T> T* GetOrCreateSubSystem()
     {
         return OverLib::GetOrCreateSubSystem<T>(_context);
     }
+    template <class T, class A1> T* GetOrCreateSubSystem(const A1& a1)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(_context, a1);
+    }
+    template <class T, class A1, class A2> T* GetOrCreateSubSystem(const A1& a1, const A2& a2)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(_context, a1, a2);
+    }
+    template <class T, class A1, class A2, class A3> T* GetOrCreateSubSystem(const A1& a1, const A2& a2, const A3& a3)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(_context, a1, a2, a3);
+    }
 
 public:
+    /// The arguments after the context are passed on to the constructor of a
+    /// created subsystem, found subsystems are cached per type
     template <class T> static T* GetOrCreateSubSystem(Urho3D::Context* context);
+    template <class T, class A1> static T* GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1);
+    template <class T, class A1, class A2> static T* GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1, const A2& a2);
+    template <class T, class A1, class A2, class A3> static T* GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1, const A2& a2, const A3& a3);
 
     template <class T> static void SendBackgroundLoadResource(Urho3D::Context* context, const Urho3D::String& name, bool sendEventOnFailure = true, Urho3D::Resource* caller = 0);
 
@@ -65,21 +108,129 @@ private:
 template <class T> T* OverLib::OverLib::GetOrCreateSubSystem(Urho3D::Context* context)
 {
     // Return existing SubSystem if possible
-    T* ss = context->GetSubsystem<T>();
+    T* ss = CachedSubsystem<T>::Get(context);
+    if (ss)
+    {
+        return ss;
+    }
+    ss = context->GetSubsystem<T>();
     if (!ss)
     {
         ss = new T(context);
         context->RegisterSubsystem(ss);
     }
+    CachedSubsystem<T>::Set(context, ss);
+    return ss;
+}
+
+template <class T, class A1> T* OverLib::OverLib::GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1)
+{
+    T* ss = CachedSubsystem<T>::Get(context);
+    if (ss)
+    {
+        return ss;
+    }
+    ss = context->GetSubsystem<T>();
+    if (!ss)
+    {
+        ss = new T(context, a1);
+        context->RegisterSubsystem(ss);
+    }
+    CachedSubsystem<T>::Set(context, ss);
+    return ss;
+}
+
+template <class T, class A1, class A2> T* OverLib::OverLib::GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1, const A2& a2)
+{
+    T* ss = CachedSubsystem<T>::Get(context);
+    if (ss)
+    {
+        return ss;
+    }
+    ss = context->GetSubsystem<T>();
+    if (!ss)
+    {
+        ss = new T(context, a1, a2);
+        context->RegisterSubsystem(ss);
+    }
+    CachedSubsystem<T>::Set(context, ss);
+    return ss;
+}
+
+template <class T, class A1, class A2, class A3> T* OverLib::OverLib::GetOrCreateSubSystem(Urho3D::Context* context, const A1& a1, const A2& a2, const A3& a3)
+{
+    T* ss = CachedSubsystem<T>::Get(context);
+    if (ss)
+    {
+        return ss;
+    }
+    ss = context->GetSubsystem<T>();
+    if (!ss)
+    {
+        ss = new T(context, a1, a2, a3);
+        context->RegisterSubsystem(ss);
+    }
+    CachedSubsystem<T>::Set(context, ss);
     return ss;
 }
 
 template <class T> void OverLib::OverLib::SendBackgroundLoadResource(Urho3D::Context* context, const Urho3D::String& name, bool sendEventOnFailure, Urho3D::Resource* caller)
 {
     Urho3D::ResourceCache* cache = context->GetSubsystem<Urho3D::ResourceCache>();
-    if(!cache->BackgroundLoadResource<T>(name, sendEventOnFailure, caller))
+    ResourceTelemetry* telemetry = context->GetSubsystem<ResourceTelemetry>();
+    ResourceScopes* scopes = context->GetSubsystem<ResourceScopes>();
+    if(scopes)
+    {
+        scopes->Track(T::GetTypeStatic(), name);
+    }
+    long long start = telemetry ? telemetry->GetTime() : 0;
+    if(cache->BackgroundLoadResource<T>(name, sendEventOnFailure, caller))
+    {
+        if(telemetry)
+        {
+            telemetry->RecordQueued(T::GetTypeStatic(), name, start);
+        }
+
+        // Without threading it was loaded right away and no event was sent
+        Urho3D::Resource* resource = cache->GetExistingResource<T>(name);
+        if(resource)
+        {
+            using namespace Urho3D::ResourceBackgroundLoaded;
+
+            Urho3D::VariantMap& eventData = context->GetEventDataMap();
+            eventData[P_RESOURCENAME] = name;
+            eventData[P_SUCCESS] = true;
+            eventData[P_RESOURCE] = resource;
+            cache->SendEvent(Urho3D::E_RESOURCEBACKGROUNDLOADED, eventData);
+        }
+    }
+    else
     {
-        Urho3D::Resource* resource = cache->GetResource<T>(name);
+        // Only told apart from a synchronous load when recording telemetry
+        Urho3D::Resource* resource = telemetry ? cache->GetExistingResource<T>(name) : 0;
+        if(telemetry)
+        {
+            if(resource)
+            {
+                telemetry->RecordCacheHit(T::GetTypeStatic());
+            }
+            else if(telemetry->IsPending(T::GetTypeStatic(), name))
+            {
+                // Already queued, GetResource only waits on that load
+                telemetry->RecordQueued(T::GetTypeStatic(), name, start);
+                resource = cache->GetResource<T>(name);
+            }
+            else
+            {
+                // Timed from before BackgroundLoadResource, which turned it down
+                resource = cache->GetResource<T>(name);
+                telemetry->RecordSyncLoad(T::GetTypeStatic(), resource, start);
+            }
+        }
+        else
+        {
+            resource = cache->GetResource<T>(name);
+        }
 
         if(!resource && sendEventOnFailure)
         {
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+enum PrefetchPriority {
+    /// Needed right now, always submitted on the next frame
+    PREFETCH_CRITICAL = 0,
+    /// Will be on screen soon
+    PREFETCH_VISIBLE,
+    /// Might be needed, only loaded when nothing else is waiting
+    PREFETCH_SPECULATIVE,
+    MAX_PREFETCH_PRIORITIES
+};
+
+/// %PrefetchScheduler able to be set as a SubSystem in Urho3D, it holds back
+/// resource requests and feeds them to the ResourceCache background queue in
+/// priority order, a few at a time, so they can still be re-prioritized or
+/// cancelled until they are actually submitted
+class URHO3D_API PrefetchScheduler : public Urho3D::Object
+{
+    OBJECT(PrefetchScheduler);
+
+public:
+    /// Construct.
+    PrefetchScheduler(Urho3D::Context* context);
+    /// Destruct.
+    ~PrefetchScheduler();
+
+public:
+    /// Queue a resource, re-requesting a queued resource only changes its priority
+    void Request(Urho3D::StringHash type, const Urho3D::String& name, PrefetchPriority priority = PREFETCH_VISIBLE);
+    template <class T> void Request(const Urho3D::String& name, PrefetchPriority priority = PREFETCH_VISIBLE)
+    {
+        Request(T::GetTypeStatic(), name, priority);
+    }
+
+    /// Returns false if the resource is not queued (or is already submitted)
+    bool SetPriority(Urho3D::StringHash type, const Urho3D::String& name, PrefetchPriority priority);
+    /// Returns false if the resource is not known, an already submitted
+    /// resource will still load but is forgotten by the scheduler
+    bool Cancel(Urho3D::StringHash type, const Urho3D::String& name);
+    /// Cancel everything still queued at the given priority
+    void CancelPriority(PrefetchPriority priority);
+
+    /// Most resources in the ResourceCache background queue at once, critical
+    /// requests ignore this
+    void SetMaxInFlight(unsigned maxInFlight) { maxInFlight_ = maxInFlight; }
+    unsigned GetMaxInFlight() const { return maxInFlight_; }
+
+    /// Main thread milliseconds per frame spent finishing background loaded
+    /// resources, forwarded to the ResourceCache
+    void SetFinishBudgetMs(int ms);
+    int GetFinishBudgetMs() const;
+
+    unsigned GetNumQueued(PrefetchPriority priority) const { return numQueued_[priority]; }
+    unsigned GetNumInFlight() const { return inFlight_; }
+    bool IsIdle() const;
+
+private:
+    void HandleUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleResourceBackgroundLoaded(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+    static Urho3D::StringHash MakeKey(Urho3D::StringHash type, const Urho3D::String& name);
+    void Submit(Urho3D::StringHash key);
+    void Enqueue(Urho3D::StringHash key, PrefetchPriority priority, unsigned sequence);
+
+private:
+    enum RequestState {
+        REQUEST_QUEUED,
+        REQUEST_INFLIGHT,
+        /// Cancelled after submission, only kept to track the in flight count
+        REQUEST_CANCELLED
+    };
+
+    struct PrefetchRequest {
+        Urho3D::StringHash type_;
+        Urho3D::String name_;
+        PrefetchPriority priority_;
+        RequestState state_;
+        /// Of its live queue entry, stale queue entries are skipped
+        unsigned sequence_;
+    };
+
+    struct QueueEntry {
+        Urho3D::StringHash key_;
+        unsigned sequence_;
+    };
+
+    struct PriorityQueue {
+        Urho3D::PODVector<QueueEntry> entries_;
+        unsigned head_;
+    };
+
+    Urho3D::HashMap<Urho3D::StringHash, PrefetchRequest> requests_;
+    PriorityQueue queues_[MAX_PREFETCH_PRIORITIES];
+    unsigned numQueued_[MAX_PREFETCH_PRIORITIES];
+    unsigned inFlight_;
+    unsigned maxInFlight_;
+    /// Given to every queue entry, never reused so an entry left behind by a
+    /// cancelled request cannot match a new request of the same resource
+    unsigned nextSequence_;
+};
+
+}
+
+}
@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %ResourceScopes attributes the resources requested through OverLib to the
+/// state they were requested for and releases them from the ResourceCache once
+/// no state that requested them is left, nothing is tracked unless it is
+/// registered as a subsystem, such as through OverLib::GetOrCreateSubSystem
+class URHO3D_API ResourceScopes : public Urho3D::Object
+{
+    OBJECT(ResourceScopes);
+
+public:
+    /// Construct.
+    ResourceScopes(Urho3D::Context* context);
+    /// Destruct.
+    ~ResourceScopes();
+
+public:
+    /// Attribute a resource to the active scope, called by the OverLib
+    /// resource loading helpers
+    void Track(Urho3D::StringHash type, const Urho3D::String& name);
+    /// Attribute a resource to the given state
+    void Track(Urho3D::Object* state, Urho3D::StringHash type, const Urho3D::String& name);
+    template <class T> void Track(Urho3D::Object* state, const Urho3D::String& name)
+    {
+        Track(state, T::GetTypeStatic(), name);
+    }
+
+    /// The state requests are attributed to, the state being loaded behind the
+    /// loading screen, else the state being preloaded, else the top state
+    Urho3D::Object* GetActiveScope() const;
+
+    /// Drop the scope of the state, done by the StateManager as it sends its
+    /// E_STATEPOSTEND, resources no other scope holds are released once the
+    /// state taking over has loaded
+    void ReleaseScope(Urho3D::Object* state);
+    /// Release every resource waiting on the incoming state now, done on every
+    /// E_STATELOADINGEND
+    void ReleasePending();
+
+    unsigned GetNumScoped(Urho3D::Object* state) const;
+    /// How many scopes hold the resource
+    unsigned GetNumReferences(Urho3D::StringHash type, const Urho3D::String& name) const;
+    unsigned GetNumPendingRelease() const { return pendingRelease_.Size(); }
+
+private:
+    Urho3D::StringHash GetResourceKey(Urho3D::StringHash type, const Urho3D::String& sanitatedName) const;
+
+private:
+    struct ScopedResource {
+        Urho3D::StringHash type_;
+        Urho3D::String name_;
+        unsigned references_;
+    };
+
+    /// Keyed by type and sanitated name
+    Urho3D::HashMap<Urho3D::StringHash, ScopedResource> resources_;
+    Urho3D::HashMap<Urho3D::Object*, Urho3D::HashSet<Urho3D::StringHash> > scopes_;
+    /// No longer referenced, released unless a scope takes them again first
+    Urho3D::PODVector<Urho3D::StringHash> pendingRelease_;
+};
+
+}
+
+}
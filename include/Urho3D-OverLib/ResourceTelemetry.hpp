@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Container/HashMap.h>
+
+namespace Urho3D
+{
+class Resource;
+}
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// Latency histogram bucket i counts loads taking [2^i, 2^(i+1)) microseconds,
+/// the last one counts everything slower
+const unsigned NUM_LATENCY_BUCKETS = 25;
+
+/// What happened to the requests for one resource type
+struct ResourceTypeTelemetry
+{
+    Urho3D::StringHash type_;
+    Urho3D::String typeName_;
+    /// Found already loaded in the ResourceCache
+    unsigned cacheHits_;
+    /// Queued for background loading
+    unsigned queued_;
+    /// Queued loads that finished
+    unsigned loaded_;
+    /// Loaded synchronously on the main thread instead
+    unsigned syncLoads_;
+    unsigned failures_;
+    /// Memory use of every resource loaded, background or sync
+    unsigned long long bytes_;
+    /// Microseconds from request until loaded, over every load
+    long long totalLatency_;
+    long long maxLatency_;
+    unsigned latencyHistogram_[NUM_LATENCY_BUCKETS];
+};
+
+/// %ResourceTelemetry records per resource type how resource requests made
+/// through SendBackgroundLoadResource, BatchLoader and PrefetchScheduler were
+/// served, nothing is recorded unless it is registered as a subsystem, such as
+/// through OverLib::GetOrCreateSubSystem
+class URHO3D_API ResourceTelemetry : public Urho3D::Object
+{
+    OBJECT(ResourceTelemetry);
+
+public:
+    /// Construct.
+    ResourceTelemetry(Urho3D::Context* context);
+    /// Destruct.
+    ~ResourceTelemetry();
+
+public:
+    /// Null if nothing of the type was requested
+    const ResourceTypeTelemetry* GetTypeTelemetry(Urho3D::StringHash type) const;
+    const Urho3D::HashMap<Urho3D::StringHash, ResourceTypeTelemetry>& GetAllTelemetry() const { return types_; }
+    /// Loads still waiting on their E_RESOURCEBACKGROUNDLOADED
+    unsigned GetNumPending() const { return pending_.Size(); }
+    /// Forget everything recorded, pending loads are still timed
+    void Reset();
+
+    /// Everything recorded as JSON, one object per resource type
+    Urho3D::String GetReport() const;
+    bool SaveReport(const Urho3D::String& fileName) const;
+
+public: // Only for use by the resource loading helpers
+    /// Microseconds since the telemetry was created
+    long long GetTime() { return timer_.GetUSec(false); }
+    /// A resource given to BackgroundLoadResource, requested at start, if it
+    /// is already loaded after (as without threading) it is a sync load
+    void RecordQueued(Urho3D::StringHash type, const Urho3D::String& name, long long start);
+    /// True while a queued load of the resource is waiting on its event
+    bool IsPending(Urho3D::StringHash type, const Urho3D::String& name) const;
+    void RecordCacheHit(Urho3D::StringHash type);
+    void RecordFailure(Urho3D::StringHash type);
+    /// A resource loaded on the main thread, requested at start
+    void RecordSyncLoad(Urho3D::StringHash type, Urho3D::Resource* resource, long long start);
+
+private:
+    Urho3D::StringHash GetPendingKey(Urho3D::StringHash type, const Urho3D::String& sanitatedName) const;
+    ResourceTypeTelemetry& GetOrCreateTypeTelemetry(Urho3D::StringHash type);
+    void RecordLatency(ResourceTypeTelemetry& telemetry, long long latency);
+    void HandleResourceBackgroundLoaded(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    struct PendingLoad {
+        Urho3D::StringHash type_;
+        long long start_;
+    };
+
+    Urho3D::HiresTimer timer_;
+    Urho3D::HashMap<Urho3D::StringHash, ResourceTypeTelemetry> types_;
+    /// Keyed by type and sanitated name, the same name may be loaded as more
+    /// than one type
+    Urho3D::HashMap<Urho3D::StringHash, PendingLoad> pending_;
+};
+
+}
+
+}
@@ -25,14 +25,25 @@
 #include <Urho3D/Core/Object.h>
 #include <Urho3D/Scene/Component.h>
 
+#include "Urho3D-OverLib/LoadingTask.hpp"
+
 #include <memory>
 
+namespace Urho3D
+{
+class XMLFile;
+}
+
 namespace Urho3D
 {
 
 namespace OverLib
 {
 
+class BatchLoader;
+class InputContext;
+class StateTransitionProfiler;
+
 EVENT(E_STATEPRESTART, StatePreStart)
 {
 }
@@ -65,24 +76,106 @@ EVENT(E_STATELOADINGEND, StateLoadingEnd)
     PARAM(P_NEWSTATE, NewState); // New StateObject
 }
 
-/// %StateObject registers event handlers by default
-class URHO3D_API StateObject : public Urho3D::Object
+/// %StateLoadingProgress is received by the Loading State while the loading
+/// state's queued LoadingTasks run, sent once per frame that any of them ran
+EVENT(E_STATELOADINGPROGRESS, StateLoadingProgress)
+{
+    PARAM(P_TASKINDEX, TaskIndex);       // unsigned, the task running now
+    PARAM(P_NUMTASKS, NumTasks);         // unsigned
+    PARAM(P_TASKPROGRESS, TaskProgress); // float, of the running task
+    PARAM(P_PROGRESS, Progress);         // float, of all the tasks
+    PARAM(P_LABEL, Label);               // String, of the running task
+}
+
+/// %StatePreloaded is sent globally once a state given to PreloadState has
+/// finished loading, a SetState to it will now switch without a loading screen
+EVENT(E_STATEPRELOADED, StatePreloaded)
+{
+    PARAM(P_STATE, State); // Preloaded StateObject
+}
+
+/// %StateSuspend is sent to a state when an overlay state is pushed above it,
+/// and again whenever what it may keep doing below the overlays changes
+EVENT(E_STATESUSPEND, StateSuspend)
+{
+    PARAM(P_KEEPUPDATING, KeepUpdating);   // bool
+    PARAM(P_KEEPRENDERING, KeepRendering); // bool
+}
+
+/// %StateResume is sent to a suspended state once it is the top state again
+EVENT(E_STATERESUME, StateResume)
+{
+}
+
+/// What the states below an overlay state keep doing while it is pushed
+enum StateOverlayFlags {
+    OVERLAY_SUSPEND_BELOW = 0,
+    OVERLAY_UPDATE_BELOW = 1,
+    OVERLAY_RENDER_BELOW = 2,
+    OVERLAY_RUN_BELOW = OVERLAY_UPDATE_BELOW | OVERLAY_RENDER_BELOW
+};
+
+/// %StateLifecycle is called directly by the StateManager for a state that
+/// implements it, no event is built for it and it needs no subscriptions,
+/// the events themselves are still sent whenever anything subscribed to them
+class URHO3D_API StateLifecycle
+{
+public:
+    /// Destruct.
+    virtual ~StateLifecycle() {}
+
+public:
+    virtual void OnStatePreStart() {}
+    virtual void OnStateStart() {}
+    virtual void OnStateEnd() {}
+    virtual void OnStatePostEnd() {}
+    virtual void OnStateSuspend(bool keepUpdating, bool keepRendering) {}
+    virtual void OnStateResume() {}
+    virtual void OnLoadingUpdate(const Urho3D::String& message) {}
+    virtual void OnLoadingProgress(unsigned taskIndex, unsigned numTasks, float taskProgress, float progress, const Urho3D::String& label) {}
+};
+
+/// %StateObject forwards its StateLifecycle calls to its event handlers, so
+/// those may be overridden as before without anything being subscribed
+class URHO3D_API StateObject : public Urho3D::Object, public StateLifecycle
 {
     OBJECT(StateObject);
 
 public:
     StateObject(Urho3D::Context* context);
 
+public:
+    virtual void OnStatePreStart();
+    virtual void OnStateStart();
+    virtual void OnStateEnd();
+    virtual void OnStatePostEnd();
+    virtual void OnStateSuspend(bool keepUpdating, bool keepRendering);
+    virtual void OnStateResume();
+    virtual void OnLoadingUpdate(const Urho3D::String& message);
+    virtual void OnLoadingProgress(unsigned taskIndex, unsigned numTasks, float taskProgress, float progress, const Urho3D::String& label);
+
 protected:
     virtual void HandleStatePreStart(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     virtual void HandleStateStart(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     virtual void HandleStateEnd(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     virtual void HandleStatePostEnd(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
     virtual void HandleLoadingUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    virtual void HandleStateSuspend(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    virtual void HandleStateResume(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    virtual void HandleLoadingProgress(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
 
 protected:
     void PostLoadingUpdate(const Urho3D::String& msg);
     void PostLoadingComplete();
+    void AddLoadingTask(LoadingTask* task);
+    void AddBackgroundTask(BackgroundTask* task);
+    /// Bindings active from this state's Start until its End, above those of
+    /// the states started before it, see InputMapper
+    void SetInputContext(InputContext* context);
+
+private:
+    /// Passed to the Handle methods of the lifecycle calls that carry data
+    Urho3D::VariantMap eventData_;
 };
 
 /// %StateManager able to be set as a SubSystem in Urho3D
@@ -105,13 +198,150 @@ public:
     void SetLoadingState(Urho3D::Object* loadingState);
     Urho3D::Object* GetLoadingState();
 
+    /// PreStart a state while the current one keeps running
+    void PreloadState(Urho3D::Object* state);
+    /// PostEnd the preloading state, if any, without ever starting it
+    void CancelPreload();
+    Urho3D::Object* GetPreloadState();
+    /// True for the current state when not transitioning, or for the
+    /// preloading state once it has posted its loading complete
+    bool IsStateReady(Urho3D::Object* state) const;
+
+    /// Resources the state needs, in the BatchLoader manifest format, when
+    /// the state is set or preloaded only those not already loaded are loaded
+    /// as a LoadingTask of the state, and once it has started those of the
+    /// outgoing state's manifest it does not share are released
+    void SetStateManifest(Urho3D::Object* state, Urho3D::XMLFile* manifest);
+    Urho3D::XMLFile* GetStateManifest(Urho3D::Object* state) const;
+
+    /// Start an overlay state above the current top state, which stays
+    /// resident and is suspended as the flags say, no loading state is shown
+    void PushState(Urho3D::Object* state, unsigned overlayFlags = OVERLAY_SUSPEND_BELOW);
+    /// End the top overlay state and resume the one below it
+    void PopState();
+    /// Swap the top overlay state for another, or SetState if there is none
+    void ReplaceState(Urho3D::Object* state, unsigned overlayFlags = OVERLAY_SUSPEND_BELOW);
+    /// The top overlay state, or the current state if there are no overlays
+    Urho3D::Object* GetTopState();
+    unsigned GetNumOverlays() const { return overlays_.Size(); }
+    Urho3D::Object* GetOverlay(unsigned index);
+
+    /// Milliseconds per frame spent running LoadingTasks
+    void SetLoadingTaskBudget(float ms) { loadingTaskBudget_ = ms; }
+    float GetLoadingTaskBudget() const { return loadingTaskBudget_; }
+
+    /// Time every lifecycle event sent and every loading screen, off by
+    /// default, turning it off drops what was recorded
+    void SetProfiling(bool enable);
+    bool GetProfiling() const { return profiler_; }
+    /// The recorded transitions, null while profiling is off
+    StateTransitionProfiler* GetProfiler() const { return profiler_; }
+
 public: // Only for use by the States themselves
+    /// Queue a task of the state's loading, once every task of a loading or
+    /// preloading state is done its loading is completed automatically, and
+    /// posting it complete before then only completes it once they are done.
+    /// A state with only a manifest loading is never completed for it, it has
+    /// to post its loading complete itself
+    void AddLoadingTask(Urho3D::Object* state, LoadingTask* task);
+    /// Queue a task of the state's loading to run on the WorkQueue once its
+    /// dependencies have finished, it counts towards the state's loading
+    /// exactly like a LoadingTask does.  Its dependencies have to be added
+    /// before it, adding it first throws
+    void AddBackgroundTask(Urho3D::Object* state, BackgroundTask* task);
+    /// True while the state has LoadingTasks or BackgroundTasks left
+    bool HasLoadingTasks(Urho3D::Object* state) const;
+
     void PostLoadingUpdate(Urho3D::String msg);
+    void PostLoadingUpdate(Urho3D::Object* state, Urho3D::String msg);
     void PostLoadingComplete();
+    void PostLoadingComplete(Urho3D::Object* state);
+
+private:
+    /// The parameters of any lifecycle event, only boxed into event data
+    /// when the event is actually sent
+    struct StateEventArgs;
+    /// Every lifecycle event goes through here so it can be profiled, a
+    /// StateLifecycle sender is called directly and the event is only sent
+    /// when something subscribed to it
+    void SendStateEvent(Urho3D::Object* sender, Urho3D::StringHash eventType);
+    void SendStateEvent(Urho3D::Object* sender, Urho3D::StringHash eventType, const StateEventArgs& args);
+    void CallStateLifecycle(StateLifecycle* lifecycle, Urho3D::StringHash eventType, const StateEventArgs& args);
+    /// Tell the InputMapper and ResourceScopes subsystems, if any, of the
+    /// lifecycle events they follow
+    void NotifySubsystems(Urho3D::Object* sender, Urho3D::StringHash eventType);
+    bool HasStateEventReceivers(Urho3D::Object* sender, Urho3D::StringHash eventType) const;
+    void SwitchToPreloadedState();
+    /// Load the missing resources of the state's manifest, if it has one
+    Urho3D::SharedPtr<BatchLoader> StartManifest(Urho3D::Object* state);
+    /// Release what the outgoing manifest has that the current one lacks
+    void ReleaseUnusedManifest();
+    void ClearOverlays();
+    unsigned FindOverlay(Urho3D::Object* state) const;
+    /// Send suspend/resume to every state whose suspension changed
+    void UpdateSuspension();
+    void RemoveLoadingTasks(Urho3D::Object* state);
+    void SendLoadingProgress();
+    void HandleLoadingTasksUpdate(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void HandleWorkItemCompleted(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+    void SubmitBackgroundTask(BackgroundTask* task);
+    void FinishBackgroundTask(BackgroundTask* task);
+    /// PostLoadingComplete the state if it is loading, has no tasks left and
+    /// either added tasks of its own or already posted its loading complete
+    void CompleteIfLoaded(Urho3D::Object* state);
+    /// The state added a task of its own, it completes once they are done
+    void OptInToAutoComplete(Urho3D::Object* state);
+    /// Drop the waiting BackgroundTasks that can never start, then complete
+    /// their states if that was all they were waiting on
+    void DropBlockedBackgroundTasks();
 
 private:
     Urho3D::SharedPtr<Urho3D::Object> state_;
     Urho3D::SharedPtr<Urho3D::Object> loadingState_;
+    Urho3D::SharedPtr<Urho3D::Object> preloadState_;
+    Urho3D::SharedPtr<StateTransitionProfiler> profiler_;
+
+    struct StateManifest {
+        Urho3D::WeakPtr<Urho3D::Object> state_;
+        Urho3D::SharedPtr<Urho3D::XMLFile> manifest_;
+    };
+
+    Urho3D::Vector<StateManifest> manifests_;
+    /// Manifests of the current and preloading states as loaded
+    Urho3D::SharedPtr<BatchLoader> manifestLoader_;
+    Urho3D::SharedPtr<BatchLoader> preloadManifestLoader_;
+    /// The outgoing state's, until the new state has started
+    Urho3D::SharedPtr<BatchLoader> releaseManifest_;
+
+    struct SuspendState {
+        bool suspended_;
+        unsigned flags_;
+    };
+
+    struct OverlayEntry {
+        Urho3D::SharedPtr<Urho3D::Object> state_;
+        unsigned overlayFlags_;
+        SuspendState suspend_;
+    };
+
+    Urho3D::Vector<OverlayEntry> overlays_;
+    SuspendState baseSuspend_;
+
+    Urho3D::Vector<Urho3D::SharedPtr<LoadingTask> > loadingTasks_;
+    /// Both waiting and running, running tasks are held until they complete
+    Urho3D::Vector<Urho3D::SharedPtr<BackgroundTask> > backgroundTasks_;
+    /// Tasks of the current loading state finished since SetState
+    unsigned loadingTasksDone_;
+    float loadingTaskBudget_;
+    bool preloadReady_;
+    /// Set while SetState is still sending its events
+    bool settingState_;
+    /// PostLoadingComplete was called from within SetState
+    bool completePending_;
+    /// The current and the preloading state complete as soon as their tasks
+    /// are done, not only their manifest's
+    bool autoComplete_;
+    bool preloadAutoComplete_;
 
     enum InternalState {
         NO_TRANSITION,
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// One lifecycle event sent during a state transition, times are in
+/// microseconds since the profiler was created
+struct StateTransitionEvent
+{
+    Urho3D::StringHash eventType_;
+    /// Type name of the object the event was sent from
+    Urho3D::String sender_;
+    long long start_;
+    /// Time spent in all the handlers of the event
+    long long duration_;
+};
+
+/// One recorded state transition, from the call that began it until its
+/// loading was completed
+struct StateTransition
+{
+    /// The StateManager call, such as SetState or PushState
+    Urho3D::String kind_;
+    Urho3D::String oldState_;
+    Urho3D::String newState_;
+    long long start_;
+    long long duration_;
+    /// Time in the loading screen, the start is -1 if there was none
+    long long loadingStart_;
+    long long loadingDuration_;
+    unsigned loadingFrames_;
+    bool finished_;
+    Urho3D::Vector<StateTransitionEvent> events_;
+};
+
+/// %StateTransitionProfiler keeps a ring buffer of the most recent state
+/// transitions of a StateManager, see StateManager::SetProfiling
+class URHO3D_API StateTransitionProfiler : public Urho3D::Object
+{
+    OBJECT(StateTransitionProfiler);
+
+public:
+    /// Construct.
+    StateTransitionProfiler(Urho3D::Context* context);
+    /// Destruct.
+    ~StateTransitionProfiler();
+
+public:
+    /// Keep at most this many transitions, clears the recorded ones
+    void SetMaxTransitions(unsigned count);
+    unsigned GetMaxTransitions() const { return records_.Size(); }
+    void Clear();
+
+    unsigned GetNumTransitions() const { return numRecords_; }
+    /// Oldest first, the last one may still be running
+    const StateTransition& GetTransition(unsigned index) const;
+
+    /// All recorded transitions as Chrome trace event JSON, as loaded by
+    /// chrome://tracing and similar trace viewers
+    Urho3D::String GetChromeTrace() const;
+    bool SaveChromeTrace(const Urho3D::String& fileName) const;
+
+public: // Only for use by the StateManager
+    /// Microseconds since the profiler was created
+    long long GetTime() { return timer_.GetUSec(false); }
+    /// Transitions begun while one is running are part of it
+    void BeginTransition(const Urho3D::String& kind, Urho3D::Object* oldState, Urho3D::Object* newState);
+    void EndTransition();
+    /// Loading frames are counted until EndLoading
+    void BeginLoading();
+    void EndLoading();
+    /// Record an event sent from start until now
+    void RecordEvent(Urho3D::Object* sender, Urho3D::StringHash eventType, long long start);
+
+private:
+    void HandleBeginFrame(Urho3D::StringHash eventType, Urho3D::VariantMap& eventData);
+
+private:
+    Urho3D::HiresTimer timer_;
+    Urho3D::Vector<StateTransition> records_;
+    /// Where the next transition is recorded
+    unsigned nextRecord_;
+    unsigned numRecords_;
+    /// Nesting of BeginTransition calls, zero when none is running
+    unsigned depth_;
+    StateTransition* current_;
+};
+
+}
+
+}
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2015 OvermindDL1.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sub-license, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Object.h>
+
+#include "Urho3D-OverLib/OverLib.hpp"
+
+namespace Urho3D
+{
+
+namespace OverLib
+{
+
+/// %SubsystemInitializer is implemented by subsystems with expensive setup
+/// that can run off the main thread, the SubsystemRegistry runs it for all the
+/// subsystems whose dependencies are met at the same time on the WorkQueue
+class URHO3D_API SubsystemInitializer
+{
+public:
+    /// Destruct.
+    virtual ~SubsystemInitializer() {}
+
+    /// Called on a worker thread after the subsystem is constructed, must not
+    /// touch anything that is not thread safe
+    virtual void InitializeAsync() = 0;
+    /// Called on the main thread once InitializeAsync has returned
+    virtual void FinishInitialize() {}
+};
+
+/// %SubsystemFactory creates one subsystem type for the SubsystemRegistry
+class URHO3D_API SubsystemFactory : public Urho3D::RefCounted
+{
+public:
+    /// Destruct.
+    virtual ~SubsystemFactory() {}
+
+    /// Create and register the subsystem, or return the one registered
+    virtual Urho3D::Object* Create(Urho3D::Context* context) = 0;
+};
+
+template <class T> class SubsystemFactoryImpl : public SubsystemFactory
+{
+public:
+    virtual Urho3D::Object* Create(Urho3D::Context* context)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(context);
+    }
+};
+
+template <class T, class A1> class SubsystemFactoryImpl1 : public SubsystemFactory
+{
+public:
+    SubsystemFactoryImpl1(const A1& a1) : a1_(a1) {}
+
+    virtual Urho3D::Object* Create(Urho3D::Context* context)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(context, a1_);
+    }
+
+private:
+    A1 a1_;
+};
+
+template <class T, class A1, class A2> class SubsystemFactoryImpl2 : public SubsystemFactory
+{
+public:
+    SubsystemFactoryImpl2(const A1& a1, const A2& a2) : a1_(a1), a2_(a2) {}
+
+    virtual Urho3D::Object* Create(Urho3D::Context* context)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(context, a1_, a2_);
+    }
+
+private:
+    A1 a1_;
+    A2 a2_;
+};
+
+template <class T, class A1, class A2, class A3> class SubsystemFactoryImpl3 : public SubsystemFactory
+{
+public:
+    SubsystemFactoryImpl3(const A1& a1, const A2& a2, const A3& a3) : a1_(a1), a2_(a2), a3_(a3) {}
+
+    virtual Urho3D::Object* Create(Urho3D::Context* context)
+    {
+        return OverLib::GetOrCreateSubSystem<T>(context, a1_, a2_, a3_);
+    }
+
+private:
+    A1 a1_;
+    A2 a2_;
+    A3 a3_;
+};
+
+/// How long one subsystem took to start, in microseconds
+struct SubsystemTiming
+{
+    Urho3D::StringHash type_;
+    Urho3D::String typeName_;
+    /// Subsystems of the same level were started together, after every lower
+    /// level
+    unsigned level_;
+    long long createTime_;
+    /// On a worker thread, zero unless it is a SubsystemInitializer
+    long long initializeTime_;
+    long long finishTime_;
+    /// Was already registered in the context, so nothing was done
+    bool existed_;
+};
+
+/// %SubsystemRegistry creates a set of subsystems in the order of their
+/// dependencies, running the InitializeAsync of those that do not depend on
+/// each other in parallel
+class URHO3D_API SubsystemRegistry : public Urho3D::Object
+{
+    OBJECT(SubsystemRegistry);
+
+public:
+    /// Construct.
+    SubsystemRegistry(Urho3D::Context* context);
+    /// Destruct.
+    ~SubsystemRegistry();
+
+public:
+    /// Register a subsystem to create in Initialize, the arguments are passed
+    /// on to its constructor after the context
+    void Register(Urho3D::StringHash type, const Urho3D::String& typeName, SubsystemFactory* factory);
+    template <class T> void Register()
+    {
+        Register(T::GetTypeStatic(), T::GetTypeNameStatic(), new SubsystemFactoryImpl<T>());
+    }
+    template <class T, class A1> void Register(const A1& a1)
+    {
+        Register(T::GetTypeStatic(), T::GetTypeNameStatic(), new SubsystemFactoryImpl1<T, A1>(a1));
+    }
+    template <class T, class A1, class A2> void Register(const A1& a1, const A2& a2)
+    {
+        Register(T::GetTypeStatic(), T::GetTypeNameStatic(), new SubsystemFactoryImpl2<T, A1, A2>(a1, a2));
+    }
+    template <class T, class A1, class A2, class A3> void Register(const A1& a1, const A2& a2, const A3& a3)
+    {
+        Register(T::GetTypeStatic(), T::GetTypeNameStatic(), new SubsystemFactoryImpl3<T, A1, A2, A3>(a1, a2, a3));
+    }
+
+    /// The type is not created until the dependency is, and its async
+    /// initialization has finished, a dependency that is not registered must
+    /// already exist in the context
+    void DependsOn(Urho3D::StringHash type, Urho3D::StringHash dependency);
+    template <class T, class D> void DependsOn()
+    {
+        DependsOn(T::GetTypeStatic(), D::GetTypeStatic());
+    }
+
+    /// Create every registered subsystem not created yet
+    void Initialize();
+
+    unsigned GetNumSubsystems() const { return entries_.Size(); }
+    const SubsystemTiming& GetTiming(unsigned index) const { return entries_[index].timing_; }
+    /// Wall time of the last Initialize
+    long long GetTotalTime() const { return totalTime_; }
+    /// A table of every subsystem's timings, level by level
+    Urho3D::String GetTimingReport() const;
+
+private:
+    /// Assign every entry not created yet its level, throws on cycles
+    unsigned ComputeLevels();
+    unsigned FindEntry(Urho3D::StringHash type) const;
+
+private:
+    struct Entry {
+        Urho3D::SharedPtr<SubsystemFactory> factory_;
+        Urho3D::PODVector<Urho3D::StringHash> dependencies_;
+        SubsystemTiming timing_;
+        bool created_;
+    };
+
+    Urho3D::Vector<Entry> entries_;
+    long long totalTime_;
+};
+
+}
+
+}